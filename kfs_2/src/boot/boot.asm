@@ -4,6 +4,8 @@ MBOOT_HEADER_MAGIC  equ 0x1BADB002
 MBOOT_HEADER_FLAGS  equ MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO
 MBOOT_CHECKSUM      equ -(MBOOT_HEADER_MAGIC + MBOOT_HEADER_FLAGS)
 STACK_SIZE          equ 16384           
+STACK_GUARD_SIZE    equ 4096
+STACK_PAINT         equ 0x57AC57AC
 GDT_KERNEL_CODE     equ 0x08            
 GDT_KERNEL_DATA     equ 0x10            
 section .multiboot
@@ -11,8 +13,11 @@ align 4
     dd MBOOT_HEADER_MAGIC               
     dd MBOOT_HEADER_FLAGS               
     dd MBOOT_CHECKSUM                   
-section .bss
-align 16
+section .bss align=4096
+global stack_bottom
+global stack_top
+stack_guard:
+    resb STACK_GUARD_SIZE
 stack_bottom:
     resb STACK_SIZE                     
 stack_top:
@@ -42,8 +47,14 @@ global gdt_flush
 extern kernel_main                      
 _start:
     cli
-    mov edi, eax                        
+    mov edx, eax                        
     mov esi, ebx                        
+    cld
+    mov edi, stack_bottom
+    mov ecx, STACK_SIZE / 4
+    mov eax, STACK_PAINT
+    rep stosd
+    mov edi, edx
     lgdt [boot_gdt_descriptor]
     jmp GDT_KERNEL_CODE:.reload_segments
 .reload_segments:
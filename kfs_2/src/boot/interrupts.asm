@@ -1,28 +1,35 @@
 extern isr_handler
 extern irq_handler
+extern irqstat_record
+extern softirq_run_pending
+extern preempt_schedule_irq
+%include "percpu.inc"
+INT_STUB_SIZE equ 16
+INT_BENCH_LEGACY_VECTOR equ 0xF1
 %macro ISR_NOERRCODE 1
-global isr_stub_%1
-isr_stub_%1:
-    cli                         
+%%entry:
     push dword 0                
     push dword %1               
     jmp isr_common_stub
+    times INT_STUB_SIZE - ($ - %%entry) db 0xCC
 %endmacro
 %macro ISR_ERRCODE 1
-global isr_stub_%1
-isr_stub_%1:
-    cli                         
+%%entry:
     push dword %1               
     jmp isr_common_stub
+    times INT_STUB_SIZE - ($ - %%entry) db 0xCC
 %endmacro
-%macro IRQ_STUB 1
-global irq_stub_%1
-irq_stub_%1:
-    cli
+%macro INT_STUB 1
+%%entry:
     push dword 0                
-    push dword (%1 + 32)        
+    push dword %1
     jmp irq_common_stub
+    times INT_STUB_SIZE - ($ - %%entry) db 0xCC
 %endmacro
+section .text
+align INT_STUB_SIZE
+global int_stub_table
+int_stub_table:
 ISR_NOERRCODE 0     
 ISR_NOERRCODE 1     
 ISR_NOERRCODE 2     
@@ -55,63 +62,159 @@ ISR_NOERRCODE 28
 ISR_NOERRCODE 29    
 ISR_ERRCODE 30      
 ISR_NOERRCODE 31    
-IRQ_STUB 0          
-IRQ_STUB 1          
-IRQ_STUB 2          
-IRQ_STUB 3          
-IRQ_STUB 4          
-IRQ_STUB 5          
-IRQ_STUB 6          
-IRQ_STUB 7          
-IRQ_STUB 8          
-IRQ_STUB 9          
-IRQ_STUB 10         
-IRQ_STUB 11         
-IRQ_STUB 12         
-IRQ_STUB 13         
-IRQ_STUB 14         
-IRQ_STUB 15         
+%assign vector 32
+%rep 224
+INT_STUB vector
+%assign vector vector + 1
+%endrep
 isr_common_stub:
-    pusha               
-    xor eax, eax        
-    mov ax, ds          
-    push eax            
-    mov ax, 0x10        
+    pusha
+    rdtsc
+    mov esi, eax
+    mov edi, edx
+    push ds
+    test byte [esp + 48], 3
+    jz .kernel_entry
+    mov ax, 0x10
     mov ds, ax
     mov es, ax
     mov fs, ax
+    str ax
+    add ax, TSS_TO_PERCPU
     mov gs, ax
-    call isr_handler    
-    pop eax             
+.kernel_entry:
+    push esp
+    call isr_handler
+    add esp, 4
+    rdtsc
+    push edx
+    push eax
+    push edi
+    push esi
+    push dword [esp + 52]
+    call irqstat_record
+    add esp, 20
+    test byte [esp + 48], 3
+    jz .kernel_exit
+    pop eax
     mov ds, ax
     mov es, ax
     mov fs, ax
     mov gs, ax
-    popa                
-    add esp, 8          
-    iret                
+    popa
+    add esp, 8
+    iret
+.kernel_exit:
+    add esp, 4
+    popa
+    add esp, 8
+    iret
 irq_common_stub:
-    pusha               
-    xor eax, eax        
-    mov ax, ds          
-    push eax            
-    mov ax, 0x10        
+    pusha
+    rdtsc
+    mov esi, eax
+    mov edi, edx
+    push ds
+    test byte [esp + 48], 3
+    jz .kernel_entry
+    mov ax, 0x10
     mov ds, ax
     mov es, ax
     mov fs, ax
+    str ax
+    add ax, TSS_TO_PERCPU
     mov gs, ax
-    mov eax, [esp + 36]
+.kernel_entry:
+    mov ebx, esp
+    inc dword [gs:PERCPU_IRQ_DEPTH]
+    cmp dword [gs:PERCPU_IRQ_DEPTH], 1
+    jne .irq_stack_ready
+    mov esp, [gs:PERCPU_IRQ_STACK_TOP]
+.irq_stack_ready:
+    push ebx
+    call irq_handler
+    rdtsc
+    push edx
     push eax
-    call irq_handler    
-    add esp, 4          
-    pop eax             
+    push edi
+    push esi
+    push dword [ebx + 36]
+    call irqstat_record
+    cmp dword [gs:PERCPU_IRQ_DEPTH], 1
+    jne .irq_unwind
+    cmp dword [gs:PERCPU_SOFTIRQ_PENDING], 0
+    je .irq_unwind
+    call softirq_run_pending
+.irq_unwind:
+    mov esp, ebx
+    dec dword [gs:PERCPU_IRQ_DEPTH]
+    jnz .irq_return
+    cmp dword [gs:PERCPU_NEED_RESCHED], 0
+    je .irq_return
+    call preempt_schedule_irq
+.irq_return:
+    test byte [esp + 48], 3
+    jz .kernel_exit
+    pop eax
     mov ds, ax
     mov es, ax
     mov fs, ax
     mov gs, ax
-    popa                
-    add esp, 8          
-    iret                
-global default_int_stub
-default_int_stub:
-    iret                
+    popa
+    add esp, 8
+    iret
+.kernel_exit:
+    add esp, 4
+    popa
+    add esp, 8
+    iret
+global int_stub_legacy
+int_stub_legacy:
+    cli
+    push dword 0
+    push dword INT_BENCH_LEGACY_VECTOR
+    jmp irq_common_stub_legacy
+irq_common_stub_legacy:
+    pusha
+    rdtsc
+    mov esi, eax
+    mov edi, edx
+    xor eax, eax
+    mov ax, ds
+    push eax
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov ebx, esp
+    mov eax, [esp + 36]
+    inc dword [gs:PERCPU_IRQ_DEPTH]
+    cmp dword [gs:PERCPU_IRQ_DEPTH], 1
+    jne .irq_stack_ready
+    mov esp, [gs:PERCPU_IRQ_STACK_TOP]
+.irq_stack_ready:
+    push eax
+    mov [esp], ebx
+    call irq_handler
+    rdtsc
+    push edx
+    push eax
+    push edi
+    push esi
+    push dword [ebx + 36]
+    call irqstat_record
+    cmp dword [gs:PERCPU_IRQ_DEPTH], 1
+    jne .irq_unwind
+    cmp dword [gs:PERCPU_SOFTIRQ_PENDING], 0
+    je .irq_unwind
+    call softirq_run_pending
+.irq_unwind:
+    mov esp, ebx
+    dec dword [gs:PERCPU_IRQ_DEPTH]
+    pop eax
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    popa
+    add esp, 8
+    iret
@@ -0,0 +1,26 @@
+extern schedule_tail
+extern kthread_exit
+section .text
+global switch_to
+switch_to:
+    mov eax, [esp + 4]
+    mov edx, [esp + 8]
+    push ebp
+    push ebx
+    push esi
+    push edi
+    mov [eax], esp
+    mov esp, edx
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+global kthread_trampoline
+kthread_trampoline:
+    call schedule_tail
+    sti
+    push esi
+    call ebx
+    add esp, 4
+    call kthread_exit
@@ -0,0 +1,88 @@
+TRAMPOLINE_BASE     equ 0x8000
+CR0_PE              equ 1 << 0
+MSR_EFER            equ 0xC0000080
+EFER_NXE            equ 1 << 11
+GDT_KERNEL_CODE     equ 0x08
+GDT_KERNEL_DATA     equ 0x10
+%define TRAMP(label) (TRAMPOLINE_BASE + (label) - trampoline_start)
+section .rodata
+global trampoline_start
+global trampoline_params
+global trampoline_end
+align 16
+[bits 16]
+trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    o32 lgdt [TRAMP(trampoline_gdt_descriptor)]
+    mov eax, cr0
+    or eax, CR0_PE
+    mov cr0, eax
+    jmp dword GDT_KERNEL_CODE:TRAMP(trampoline_32)
+[bits 32]
+trampoline_32:
+    mov ax, GDT_KERNEL_DATA
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    mov eax, [TRAMP(trampoline_cr4)]
+    mov cr4, eax
+    mov eax, [TRAMP(trampoline_cr3)]
+    mov cr3, eax
+    cmp dword [TRAMP(trampoline_efer_nx)], 0
+    je .paging
+    mov ecx, MSR_EFER
+    rdmsr
+    or eax, EFER_NXE
+    wrmsr
+.paging:
+    mov eax, [TRAMP(trampoline_cr0)]
+    mov cr0, eax
+    mov esp, [TRAMP(trampoline_stack)]
+    xor ebp, ebp
+    push dword [TRAMP(trampoline_cpu)]
+    mov eax, [TRAMP(trampoline_entry)]
+    call eax
+.hang:
+    cli
+    hlt
+    jmp .hang
+align 8
+trampoline_gdt:
+    dq 0x0000000000000000
+    dw 0xFFFF
+    dw 0x0000
+    db 0x00
+    db 0x9A
+    db 0xCF
+    db 0x00
+    dw 0xFFFF
+    dw 0x0000
+    db 0x00
+    db 0x92
+    db 0xCF
+    db 0x00
+trampoline_gdt_descriptor:
+    dw trampoline_gdt_descriptor - trampoline_gdt - 1
+    dd TRAMP(trampoline_gdt)
+align 4
+trampoline_params:
+trampoline_cr3:
+    dd 0
+trampoline_cr4:
+    dd 0
+trampoline_cr0:
+    dd 0
+trampoline_efer_nx:
+    dd 0
+trampoline_stack:
+    dd 0
+trampoline_entry:
+    dd 0
+trampoline_cpu:
+    dd 0
+trampoline_end:
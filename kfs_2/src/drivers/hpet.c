@@ -0,0 +1,206 @@
+#include "../include/hpet.h"
+#include "../include/idt.h"
+#include "../include/cpu.h"
+#include "../include/acpi.h"
+#include "../include/paging.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
+
+static volatile uint32_t    *g_hpet;
+static t_hpet_info          g_hpet_info;
+
+static ALWAYS_INLINE uint32_t hpet_read(uint32_t reg)
+{
+    return (g_hpet[reg / 4]);
+}
+
+static ALWAYS_INLINE void hpet_write(uint32_t reg, uint32_t value)
+{
+    g_hpet[reg / 4] = value;
+}
+
+static int hpet_handler(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+
+    tick_handle();
+    return (IRQ_HANDLED);
+}
+
+static uint32_t hpet_ns_to_ticks(uint64_t ns)
+{
+    uint64_t    ticks;
+
+    ticks = k_udivmod64(ns * HPET_FS_PER_NS, g_hpet_info.period_fs, NULL);
+    if (ticks == 0)
+    {
+        return (1);
+    }
+    if (ticks > 0x7FFFFFFFULL)
+    {
+        return (0x7FFFFFFFU);
+    }
+    return ((uint32_t)ticks);
+}
+
+uint32_t hpet_read_counter(void)
+{
+    return (hpet_read(HPET_MAIN_CNT));
+}
+
+void hpet_set_periodic(uint32_t hz)
+{
+    uint32_t    ticks;
+    uint32_t    conf;
+    uint32_t    flags;
+
+    ticks = hpet_ns_to_ticks(NSEC_PER_SEC / hz);
+    flags = irq_save();
+    conf = hpet_read(HPET_GEN_CONF);
+    hpet_write(HPET_GEN_CONF, conf & ~HPET_CONF_ENABLE);
+    hpet_write(HPET_MAIN_CNT, 0);
+    hpet_write(HPET_MAIN_CNT + 4, 0);
+    hpet_write(HPET_TN_CONF(0), HPET_TN_INT_ENB | HPET_TN_TYPE_PERIODIC |
+               HPET_TN_VAL_SET | HPET_TN_32MODE);
+    hpet_write(HPET_TN_CMP(0), ticks);
+    hpet_write(HPET_TN_CMP(0), ticks);
+    hpet_write(HPET_GEN_CONF, conf | HPET_CONF_ENABLE);
+    irq_restore(flags);
+}
+
+void hpet_set_oneshot(uint64_t delta_ns)
+{
+    uint32_t    ticks;
+    uint32_t    cmp;
+
+    ticks = hpet_ns_to_ticks(delta_ns);
+    hpet_write(HPET_TN_CONF(0), HPET_TN_INT_ENB | HPET_TN_32MODE);
+    do
+    {
+        cmp = hpet_read_counter() + ticks;
+        hpet_write(HPET_TN_CMP(0), cmp);
+        ticks <<= 1;
+    } while ((int32_t)(hpet_read_counter() - cmp) >= 0);
+}
+
+const t_clockevent  g_hpet_clockevent = {
+    "HPET",
+    HPET_ONESHOT_MIN_NS,
+    HPET_ONESHOT_MAX_NS,
+    hpet_set_periodic,
+    hpet_set_oneshot
+};
+
+int __init hpet_init(void)
+{
+    const t_acpi_info   *acpi;
+    uint32_t            cap;
+    uint32_t            i;
+
+    acpi = acpi_get_info();
+    if (!acpi->has_hpet)
+    {
+        return (-1);
+    }
+    g_hpet = (volatile uint32_t *)paging_map_mmio(
+        (phys_addr_t)acpi->hpet_address, HPET_MMIO_SIZE);
+    if (g_hpet == NULL)
+    {
+        return (-1);
+    }
+    cap = hpet_read(HPET_GCAP_ID);
+    g_hpet_info.period_fs = hpet_read(HPET_GCAP_ID + 4);
+    if (g_hpet_info.period_fs == 0 ||
+        g_hpet_info.period_fs > HPET_MAX_PERIOD_FS)
+    {
+        return (-1);
+    }
+    g_hpet_info.timers = HPET_CAP_NUM_TIM(cap);
+    g_hpet_info.counter_64 = (bool_t)((cap & HPET_CAP_COUNT_64) != 0);
+    g_hpet_info.legacy_route = (bool_t)((cap & HPET_CAP_LEG_RT) != 0);
+    g_hpet_info.periodic = (bool_t)(
+        (hpet_read(HPET_TN_CONF(0)) & HPET_TN_PER_INT_CAP) != 0);
+    g_hpet_info.freq_khz = (uint32_t)k_udivmod64(1000000000000ULL,
+                                                 g_hpet_info.period_fs, NULL);
+
+
+    hpet_write(HPET_GEN_CONF, 0);
+    for (i = 0; i < g_hpet_info.timers; i++)
+    {
+        hpet_write(HPET_TN_CONF(i), 0);
+    }
+    hpet_write(HPET_MAIN_CNT, 0);
+    hpet_write(HPET_MAIN_CNT + 4, 0);
+    hpet_write(HPET_GEN_CONF, HPET_CONF_ENABLE);
+    g_hpet_info.present = TRUE;
+    return (0);
+}
+
+void __init hpet_enable_clockevent(void)
+{
+    hpet_write(HPET_GEN_CONF, hpet_read(HPET_GEN_CONF) | HPET_CONF_LEG_RT);
+    irq_register(HPET_IRQ, hpet_handler, NULL);
+}
+
+bool_t hpet_available(void)
+{
+    return (g_hpet_info.present);
+}
+
+const t_hpet_info *hpet_get_info(void)
+{
+    return (&g_hpet_info);
+}
+
+static uint64_t __init hpet_measure_tsc(uint32_t ticks, uint64_t *skew)
+{
+    uint64_t    t0;
+    uint64_t    t1;
+    uint64_t    t2;
+    uint64_t    t3;
+    uint64_t    elapsed_ns;
+    uint32_t    start;
+    uint32_t    end;
+
+    t0 = rdtsc();
+    start = hpet_read_counter();
+    t1 = rdtsc();
+    while (hpet_read_counter() - start < ticks)
+    {
+    }
+    t2 = rdtsc();
+    end = hpet_read_counter();
+    t3 = rdtsc();
+    *skew = (t1 - t0) + (t3 - t2);
+    elapsed_ns = k_udivmod64((uint64_t)(end - start) * g_hpet_info.period_fs,
+                             HPET_FS_PER_NS, NULL);
+    return (k_udivmod64(((t2 + t3 - t0 - t1) >> 1) * NSEC_PER_MSEC,
+                        (uint32_t)elapsed_ns, NULL));
+}
+
+uint32_t __init hpet_calibrate_tsc_khz(void)
+{
+    uint64_t    best_skew;
+    uint64_t    best;
+    uint64_t    skew;
+    uint64_t    khz;
+    uint32_t    flags;
+    uint32_t    i;
+
+    flags = irq_save();
+    best = 0;
+    best_skew = 0;
+    for (i = 0; i < HPET_CALIBRATE_TRIALS; i++)
+    {
+        khz = hpet_measure_tsc(
+            (uint32_t)(g_hpet_info.freq_khz * HPET_CALIBRATE_MS), &skew);
+        if (best == 0 || skew < best_skew)
+        {
+            best = khz;
+            best_skew = skew;
+        }
+    }
+    irq_restore(flags);
+    return ((uint32_t)best);
+}
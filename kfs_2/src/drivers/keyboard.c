@@ -1,5 +1,12 @@
+#include "../kernel/kernel.h"
 #include "../include/keyboard.h"
-#include "../include/pic.h"
+#include "../include/idt.h"
+#include "../include/softirq.h"
+#include "../include/wait.h"
+#include "../include/spinlock.h"
+#include "../include/cpu.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
 
 static inline uint8_t inb(uint16_t port)
 {
@@ -43,10 +50,25 @@ static t_key_event      g_key_buffer[KEYBOARD_BUFFER_SIZE];
 static size_t           g_buffer_read;
 static size_t           g_buffer_write;
 static size_t           g_buffer_count;
+static t_spinlock       g_buffer_lock = SPINLOCK_INIT("keyboard");
 static uint8_t          g_last_scancode;
 static uint32_t         g_debounce_counter;
 
-void keyboard_init(void)
+static volatile uint8_t g_raw_scancodes[KEYBOARD_RAW_SIZE];
+static volatile uint8_t g_raw_head;
+static volatile uint8_t g_raw_tail;
+static uint64_t         g_raw_tsc[KEYBOARD_RAW_SIZE];
+
+static t_wait_queue     g_kb_wait = WAIT_QUEUE_INIT(g_kb_wait);
+static uint64_t         g_kb_wake_tsc;
+static t_kb_latency     g_kb_irq_to_wake;
+static t_kb_latency     g_kb_wake_to_run;
+
+static void keyboard_tasklet(void *data);
+
+static t_tasklet        g_kb_tasklet = TASKLET_INIT(keyboard_tasklet, NULL);
+
+void __init keyboard_init(void)
 {
     size_t i;
 
@@ -60,6 +82,8 @@ void keyboard_init(void)
     g_buffer_count = 0;
     g_last_scancode = 0;
     g_debounce_counter = 0;
+    g_raw_head = 0;
+    g_raw_tail = 0;
 
     i = 0;
     while (i < KEYBOARD_BUFFER_SIZE)
@@ -67,11 +91,11 @@ void keyboard_init(void)
         g_key_buffer[i].scancode = 0;
         g_key_buffer[i].ascii = 0;
         g_key_buffer[i].pressed = FALSE;
+        g_key_buffer[i].irq_tsc = 0;
         i++;
     }
 
-
-    pic_clear_mask(1);
+    irq_register(1, keyboard_handler, NULL);
 }
 
 static char scancode_to_ascii(uint8_t scancode)
@@ -130,14 +154,12 @@ static void buffer_add_key(t_key_event event)
     g_buffer_count++;
 }
 
-void keyboard_handler(void)
+static void keyboard_translate(uint8_t scancode, uint64_t irq_tsc)
 {
-    uint8_t         scancode;
     bool_t          pressed;
     t_key_event     event;
     bool_t          is_duplicate;
 
-    scancode = inb(KEYBOARD_DATA_PORT);
     pressed = (bool_t)((scancode & KEY_RELEASED_OFFSET) == 0);
 
     if (!pressed)
@@ -156,13 +178,13 @@ void keyboard_handler(void)
     if (is_duplicate)
     {
         g_debounce_counter++;
-        pic_send_eoi(1);
         return;
     }
 
     event.scancode = scancode;
     event.ascii = scancode_to_ascii(scancode);
     event.pressed = pressed;
+    event.irq_tsc = irq_tsc;
 
     if (pressed)
     {
@@ -170,8 +192,48 @@ void keyboard_handler(void)
         g_last_scancode = scancode;
         g_debounce_counter = 0;
     }
+}
+
+static void keyboard_tasklet(void *data)
+{
+    uint8_t     scancode;
+    uint64_t    irq_tsc;
+
+    (void)data;
+    while (g_raw_tail != g_raw_head)
+    {
+        scancode = g_raw_scancodes[g_raw_tail];
+        irq_tsc = g_raw_tsc[g_raw_tail];
+        g_raw_tail = (uint8_t)((g_raw_tail + 1) % KEYBOARD_RAW_SIZE);
+        spin_lock(&g_buffer_lock);
+        keyboard_translate(scancode, irq_tsc);
+        spin_unlock(&g_buffer_lock);
+    }
+    if (g_buffer_count > 0 && wait_queue_active(&g_kb_wait))
+    {
+        g_kb_wake_tsc = rdtsc();
+        wake_up_nr(&g_kb_wait, g_buffer_count);
+    }
+}
+
+int keyboard_handler(t_regs *regs, void *ctx)
+{
+    uint8_t     scancode;
+    uint8_t     next;
+
+    (void)regs;
+    (void)ctx;
 
-    pic_send_eoi(1);
+    scancode = inb(KEYBOARD_DATA_PORT);
+    next = (uint8_t)((g_raw_head + 1) % KEYBOARD_RAW_SIZE);
+    if (next != g_raw_tail)
+    {
+        g_raw_scancodes[g_raw_head] = scancode;
+        g_raw_tsc[g_raw_head] = rdtsc();
+        g_raw_head = next;
+    }
+    tasklet_schedule(&g_kb_tasklet);
+    return (IRQ_HANDLED);
 }
 
 bool_t keyboard_has_key(void)
@@ -183,31 +245,104 @@ t_key_event keyboard_get_key(void)
 {
     t_key_event event;
 
+    event.scancode = 0;
+    event.ascii = 0;
+    event.pressed = FALSE;
     if (g_buffer_count == 0)
     {
-        event.scancode = 0;
-        event.ascii = 0;
-        event.pressed = FALSE;
         return (event);
     }
 
-    event = g_key_buffer[g_buffer_read];
-    g_buffer_read = (g_buffer_read + 1) % KEYBOARD_BUFFER_SIZE;
-    g_buffer_count--;
+    spin_lock_bh(&g_buffer_lock);
+    if (g_buffer_count > 0)
+    {
+        event = g_key_buffer[g_buffer_read];
+        g_buffer_read = (g_buffer_read + 1) % KEYBOARD_BUFFER_SIZE;
+        g_buffer_count--;
+    }
+    spin_unlock_bh(&g_buffer_lock);
 
     return (event);
 }
 
+static void kb_latency_record(t_kb_latency *stat, uint64_t cycles)
+{
+    stat->count++;
+    stat->total += cycles;
+    if (stat->min == 0 || cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+}
+
+void keyboard_wait(void)
+{
+    uint64_t    now;
+
+    if (keyboard_has_key())
+    {
+        return;
+    }
+    wait_event(&g_kb_wait, keyboard_has_key());
+    now = rdtsc();
+    spin_lock_bh(&g_buffer_lock);
+    if (g_buffer_count > 0 && g_key_buffer[g_buffer_read].irq_tsc != 0 &&
+        g_kb_wake_tsc >= g_key_buffer[g_buffer_read].irq_tsc)
+    {
+        kb_latency_record(&g_kb_irq_to_wake,
+                          g_kb_wake_tsc - g_key_buffer[g_buffer_read].irq_tsc);
+        kb_latency_record(&g_kb_wake_to_run, now - g_kb_wake_tsc);
+    }
+    spin_unlock_bh(&g_buffer_lock);
+}
+
+static void kb_latency_print(const char *name, const t_kb_latency *stat)
+{
+    uint64_t    avg;
+
+    if (stat->count == 0)
+    {
+        printk("  %s: no samples\n", name);
+        return;
+    }
+    avg = k_udivmod64(stat->total, stat->count, NULL);
+    printk("  %s: min %llu  avg %llu  max %llu cycles", name, stat->min, avg,
+           stat->max);
+    printk(" (avg %llu ns)\n", cycles_to_ns(avg));
+}
+
+void keyboard_print_latency(void)
+{
+    printk("\n=== Keyboard wakeup latency (%u samples) ===\n",
+           g_kb_irq_to_wake.count);
+    kb_latency_print("IRQ -> wake_up ", &g_kb_irq_to_wake);
+    kb_latency_print("wake_up -> task", &g_kb_wake_to_run);
+    printk("  waiters woken: %u\n", g_kb_wait.wakeups);
+    printk("\n");
+}
+
+void keyboard_reset_latency(void)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    k_memset(&g_kb_irq_to_wake, 0, sizeof(g_kb_irq_to_wake));
+    k_memset(&g_kb_wake_to_run, 0, sizeof(g_kb_wake_to_run));
+    g_kb_wait.wakeups = 0;
+    irq_restore(flags);
+}
+
 char keyboard_getchar(void)
 {
     t_key_event event;
 
     while (1)
     {
-        while (!keyboard_has_key())
-        {
-            __asm__ volatile ("hlt");
-        }
+        keyboard_wait();
 
         event = keyboard_get_key();
 
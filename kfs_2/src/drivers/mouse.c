@@ -1,5 +1,5 @@
 #include "../include/mouse.h"
-#include "../include/pic.h"
+#include "../include/idt.h"
 
 static inline void outb(uint16_t port, uint8_t value)
 {
@@ -23,7 +23,7 @@ static uint8_t          g_mouse_cycle;
 static uint8_t          g_mouse_packet[4];
 static bool_t           g_mouse_has_wheel;
 
-static void mouse_wait_write(void)
+static void __init mouse_wait_write(void)
 {
     uint32_t timeout;
 
@@ -38,7 +38,7 @@ static void mouse_wait_write(void)
     }
 }
 
-static void mouse_wait_read(void)
+static void __init mouse_wait_read(void)
 {
     uint32_t timeout;
 
@@ -53,7 +53,7 @@ static void mouse_wait_read(void)
     }
 }
 
-static void mouse_write(uint8_t data)
+static void __init mouse_write(uint8_t data)
 {
     mouse_wait_write();
     outb(MOUSE_COMMAND_PORT, MOUSE_CMD_WRITE_MOUSE);
@@ -61,13 +61,13 @@ static void mouse_write(uint8_t data)
     outb(MOUSE_DATA_PORT, data);
 }
 
-static uint8_t mouse_read(void)
+static uint8_t __init mouse_read(void)
 {
     mouse_wait_read();
     return (inb(MOUSE_DATA_PORT));
 }
 
-static bool_t mouse_enable_wheel(void)
+static bool_t __init mouse_enable_wheel(void)
 {
     uint8_t device_id;
 
@@ -95,7 +95,7 @@ static bool_t mouse_enable_wheel(void)
     return (device_id == 3);
 }
 
-void mouse_init(void)
+void __init mouse_init(void)
 {
     uint8_t status;
 
@@ -131,24 +131,24 @@ void mouse_init(void)
     mouse_write(MOUSE_ENABLE_PACKET);
     mouse_read();
 
-
-    pic_clear_mask(2);
-    pic_clear_mask(12);
+    irq_register(12, mouse_handler, NULL);
 }
 
-void mouse_handler(void)
+int mouse_handler(t_regs *regs, void *ctx)
 {
     uint8_t         data;
     t_mouse_event   event;
     size_t          next_idx;
 
+    (void)regs;
+    (void)ctx;
+
     data = inb(MOUSE_DATA_PORT);
 
 
     if (g_mouse_cycle == 0 && (data & MOUSE_ALWAYS_ONE) == 0)
     {
-        pic_send_eoi(12);
-        return;
+        return (IRQ_HANDLED);
     }
 
     g_mouse_packet[g_mouse_cycle] = data;
@@ -163,8 +163,7 @@ void mouse_handler(void)
 
         if ((g_mouse_packet[0] & (MOUSE_X_OVERFLOW | MOUSE_Y_OVERFLOW)) != 0)
         {
-            pic_send_eoi(12);
-            return;
+            return (IRQ_HANDLED);
         }
 
 
@@ -197,7 +196,7 @@ void mouse_handler(void)
         }
     }
 
-    pic_send_eoi(12);
+    return (IRQ_HANDLED);
 }
 
 bool_t mouse_has_event(void)
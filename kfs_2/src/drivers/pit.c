@@ -0,0 +1,145 @@
+#include "../include/pit.h"
+#include "../include/idt.h"
+#include "../include/cpu.h"
+#include "../include/time.h"
+#include "../lib/math.h"
+
+static inline void outb(uint16_t port, uint8_t value)
+{
+    __asm__ volatile ("outb %0, %1" : : "a"(value), "Nd"(port));
+}
+
+static inline uint8_t inb(uint16_t port)
+{
+    uint8_t ret;
+    __asm__ volatile ("inb %1, %0" : "=a"(ret) : "Nd"(port));
+    return (ret);
+}
+
+static uint32_t g_pit_hz;
+
+static int pit_handler(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+
+    tick_handle();
+    return (IRQ_HANDLED);
+}
+
+void pit_set_periodic(uint32_t hz)
+{
+    uint32_t    divisor;
+    uint32_t    flags;
+
+    if (hz < PIT_MIN_FREQ)
+    {
+        hz = PIT_MIN_FREQ;
+    }
+    if (hz > PIT_MAX_FREQ)
+    {
+        hz = PIT_MAX_FREQ;
+    }
+    divisor = (PIT_BASE_FREQ + hz / 2) / hz;
+    if (divisor > 0xFFFF)
+    {
+        divisor = 0xFFFF;
+    }
+    flags = irq_save();
+    outb(PIT_COMMAND, PIT_CMD_CHANNEL0 | PIT_CMD_LOHI | PIT_CMD_MODE2);
+    outb(PIT_CHANNEL0, (uint8_t)(divisor & 0xFF));
+    outb(PIT_CHANNEL0, (uint8_t)(divisor >> 8));
+    irq_restore(flags);
+    g_pit_hz = PIT_BASE_FREQ / divisor;
+}
+
+void pit_set_oneshot(uint64_t delta_ns)
+{
+    uint64_t    count;
+
+    count = k_udivmod64(delta_ns * PIT_BASE_FREQ, 1000000000U, NULL);
+    if (count == 0)
+    {
+        count = 1;
+    }
+    if (count > 0xFFFF)
+    {
+        count = 0xFFFF;
+    }
+    outb(PIT_COMMAND, PIT_CMD_CHANNEL0 | PIT_CMD_LOHI | PIT_CMD_MODE0);
+    outb(PIT_CHANNEL0, (uint8_t)(count & 0xFF));
+    outb(PIT_CHANNEL0, (uint8_t)(count >> 8));
+}
+
+const t_clockevent  g_pit_clockevent = {
+    "PIT",
+    PIT_ONESHOT_MIN_NS,
+    PIT_ONESHOT_MAX_NS,
+    pit_set_periodic,
+    pit_set_oneshot
+};
+
+void __init pit_init(uint32_t hz)
+{
+    pit_set_periodic(hz);
+    irq_register(PIT_IRQ, pit_handler, NULL);
+}
+
+uint32_t pit_frequency(void)
+{
+    return (g_pit_hz);
+}
+
+uint16_t pit_read_count(void)
+{
+    uint32_t    flags;
+    uint8_t     lo;
+    uint8_t     hi;
+
+    flags = irq_save();
+    outb(PIT_COMMAND, PIT_CMD_CHANNEL0 | PIT_CMD_LATCH);
+    lo = inb(PIT_CHANNEL0);
+    hi = inb(PIT_CHANNEL0);
+    irq_restore(flags);
+    return ((uint16_t)(((uint16_t)hi << 8) | lo));
+}
+
+static uint64_t __init pit_measure_tsc(uint16_t latch)
+{
+    uint64_t    start;
+    uint8_t     port_b;
+
+    port_b = inb(PIT_PORT_B);
+    outb(PIT_PORT_B, (uint8_t)((port_b & ~PIT_PORTB_SPEAKER) | PIT_PORTB_GATE2));
+    outb(PIT_COMMAND, PIT_CMD_CHANNEL2 | PIT_CMD_LOHI | PIT_CMD_MODE0);
+    outb(PIT_CHANNEL2, (uint8_t)(latch & 0xFF));
+    outb(PIT_CHANNEL2, (uint8_t)(latch >> 8));
+    start = rdtsc();
+    while ((inb(PIT_PORT_B) & PIT_PORTB_OUT2) == 0)
+    {
+    }
+    start = rdtsc() - start;
+    outb(PIT_PORT_B, port_b);
+    return (start);
+}
+
+uint32_t __init pit_calibrate_tsc_khz(void)
+{
+    uint64_t    best;
+    uint64_t    delta;
+    uint32_t    flags;
+    uint32_t    i;
+
+    flags = irq_save();
+    best = 0;
+    for (i = 0; i < PIT_CALIBRATE_TRIALS; i++)
+    {
+        delta = pit_measure_tsc((uint16_t)(PIT_BASE_FREQ * PIT_CALIBRATE_MS / 1000));
+        if (best == 0 || delta < best)
+        {
+            best = delta;
+        }
+    }
+    irq_restore(flags);
+    return ((uint32_t)k_udivmod64(best, PIT_CALIBRATE_MS, NULL));
+}
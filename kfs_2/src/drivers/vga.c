@@ -26,7 +26,7 @@ static inline size_t vga_index(size_t x, size_t y)
     return (y * VGA_WIDTH + x);
 }
 
-void vga_init(void)
+void __init vga_init(void)
 {
     g_terminal.cursor_row = 0;
     g_terminal.cursor_col = 0;
@@ -0,0 +1,165 @@
+#ifndef ACPI_H
+# define ACPI_H
+
+# include "types.h"
+
+# define ACPI_RSDP_SIGNATURE    "RSD PTR "
+# define ACPI_EBDA_PTR          0x040E
+# define ACPI_BIOS_START        0x000E0000U
+# define ACPI_BIOS_END          0x00100000U
+
+# define ACPI_MAX_TABLES        32
+# define ACPI_MAX_CPUS          16
+# define ACPI_MAX_IOAPICS       4
+# define ACPI_MAX_OVERRIDES     16
+
+# define MADT_LAPIC             0
+# define MADT_IOAPIC            1
+# define MADT_ISO               2
+# define MADT_LAPIC_NMI         4
+# define MADT_LAPIC_OVERRIDE    5
+
+# define MADT_LAPIC_ENABLED     (1U << 0)
+# define MADT_LAPIC_ONLINE_CAP  (1U << 1)
+# define MADT_PCAT_COMPAT       (1U << 0)
+
+typedef struct PACKED s_acpi_rsdp
+{
+    char        signature[8];
+    uint8_t     checksum;
+    char        oem_id[6];
+    uint8_t     revision;
+    uint32_t    rsdt_address;
+    uint32_t    length;
+    uint64_t    xsdt_address;
+    uint8_t     ext_checksum;
+    uint8_t     reserved[3];
+}   t_acpi_rsdp;
+
+typedef struct PACKED s_acpi_header
+{
+    char        signature[4];
+    uint32_t    length;
+    uint8_t     revision;
+    uint8_t     checksum;
+    char        oem_id[6];
+    char        oem_table_id[8];
+    uint32_t    oem_revision;
+    uint32_t    creator_id;
+    uint32_t    creator_revision;
+}   t_acpi_header;
+
+typedef struct PACKED s_acpi_gas
+{
+    uint8_t     space_id;
+    uint8_t     bit_width;
+    uint8_t     bit_offset;
+    uint8_t     access_size;
+    uint64_t    address;
+}   t_acpi_gas;
+
+typedef struct PACKED s_acpi_madt
+{
+    t_acpi_header   header;
+    uint32_t        lapic_address;
+    uint32_t        flags;
+}   t_acpi_madt;
+
+typedef struct PACKED s_madt_entry
+{
+    uint8_t     type;
+    uint8_t     length;
+}   t_madt_entry;
+
+typedef struct PACKED s_madt_lapic
+{
+    t_madt_entry    entry;
+    uint8_t         acpi_id;
+    uint8_t         apic_id;
+    uint32_t        flags;
+}   t_madt_lapic;
+
+typedef struct PACKED s_madt_ioapic
+{
+    t_madt_entry    entry;
+    uint8_t         id;
+    uint8_t         reserved;
+    uint32_t        address;
+    uint32_t        gsi_base;
+}   t_madt_ioapic;
+
+typedef struct PACKED s_madt_iso
+{
+    t_madt_entry    entry;
+    uint8_t         bus;
+    uint8_t         source;
+    uint32_t        gsi;
+    uint16_t        flags;
+}   t_madt_iso;
+
+typedef struct PACKED s_madt_lapic_override
+{
+    t_madt_entry    entry;
+    uint16_t        reserved;
+    uint64_t        address;
+}   t_madt_lapic_override;
+
+typedef struct PACKED s_acpi_hpet
+{
+    t_acpi_header   header;
+    uint32_t        event_timer_block_id;
+    t_acpi_gas      address;
+    uint8_t         hpet_number;
+    uint16_t        min_tick;
+    uint8_t         page_protection;
+}   t_acpi_hpet;
+
+typedef struct s_acpi_cpu
+{
+    uint8_t     acpi_id;
+    uint8_t     apic_id;
+    bool_t      enabled;
+}   t_acpi_cpu;
+
+typedef struct s_acpi_ioapic
+{
+    uint8_t     id;
+    uint32_t    address;
+    uint32_t    gsi_base;
+}   t_acpi_ioapic;
+
+typedef struct s_acpi_override
+{
+    uint8_t     source;
+    uint32_t    gsi;
+    uint16_t    flags;
+}   t_acpi_override;
+
+typedef struct s_acpi_info
+{
+    bool_t              present;
+    uint8_t             revision;
+    char                oem_id[7];
+    uint32_t            table_count;
+    uint32_t            tables[ACPI_MAX_TABLES];
+    bool_t              has_madt;
+    uint32_t            lapic_address;
+    bool_t              pcat_compat;
+    uint32_t            cpu_count;
+    t_acpi_cpu          cpus[ACPI_MAX_CPUS];
+    uint32_t            ioapic_count;
+    t_acpi_ioapic       ioapics[ACPI_MAX_IOAPICS];
+    uint32_t            override_count;
+    t_acpi_override     overrides[ACPI_MAX_OVERRIDES];
+    bool_t              has_hpet;
+    uint32_t            hpet_address;
+    uint8_t             hpet_number;
+    uint16_t            hpet_min_tick;
+}   t_acpi_info;
+
+void                acpi_init(void);
+const t_acpi_info   *acpi_get_info(void);
+const t_acpi_header *acpi_find_table(const char *signature);
+void                acpi_print(void);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef APIC_H
+# define APIC_H
+
+# include "types.h"
+# include "tick.h"
+
+# define MSR_APIC_BASE              0x1B
+# define APIC_BASE_BSP              (1U << 8)
+# define APIC_BASE_ENABLE           (1U << 11)
+# define APIC_BASE_ADDR_MASK        0xFFFFF000U
+
+# define APIC_DEFAULT_BASE          0xFEE00000U
+
+# define LAPIC_ID                   0x020
+# define LAPIC_VERSION              0x030
+# define LAPIC_TPR                  0x080
+# define LAPIC_EOI                  0x0B0
+# define LAPIC_LDR                  0x0D0
+# define LAPIC_DFR                  0x0E0
+# define LAPIC_SVR                  0x0F0
+# define LAPIC_ESR                  0x280
+# define LAPIC_ICR_LOW              0x300
+# define LAPIC_ICR_HIGH             0x310
+# define LAPIC_LVT_TIMER            0x320
+# define LAPIC_LVT_LINT0            0x350
+# define LAPIC_LVT_LINT1            0x360
+# define LAPIC_LVT_ERROR            0x370
+# define LAPIC_TIMER_INITIAL        0x380
+# define LAPIC_TIMER_CURRENT        0x390
+# define LAPIC_TIMER_DIVIDE         0x3E0
+
+# define LAPIC_SVR_ENABLE           (1U << 8)
+# define LAPIC_LVT_MASKED           (1U << 16)
+# define LAPIC_LVT_PERIODIC         (1U << 17)
+# define LAPIC_LVT_NMI              (4U << 8)
+# define LAPIC_TIMER_DIV_16         0x3
+
+# define LAPIC_ICR_FIXED            (0U << 8)
+# define LAPIC_ICR_NMI              (4U << 8)
+# define LAPIC_ICR_INIT             (5U << 8)
+# define LAPIC_ICR_STARTUP          (6U << 8)
+# define LAPIC_ICR_PENDING          (1U << 12)
+# define LAPIC_ICR_ASSERT           (1U << 14)
+# define LAPIC_ICR_LEVEL            (1U << 15)
+# define LAPIC_ICR_SELF             (1U << 18)
+# define LAPIC_ICR_ALL              (2U << 18)
+# define LAPIC_ICR_OTHERS           (3U << 18)
+# define LAPIC_ICR_DEST_SHIFT       24
+
+# define APIC_TIMER_VECTOR          0xEF
+# define LAPIC_CALIBRATE_NS         10000000ULL
+# define LAPIC_ONESHOT_MIN_NS       1000ULL
+# define LAPIC_ONESHOT_MAX_NS       1000000000ULL
+# define APIC_SPURIOUS_VECTOR       0xFF
+
+# define IOAPIC_DEFAULT_BASE        0xFEC00000U
+# define IOAPIC_MAX                 4
+# define IOAPIC_REGSEL              0x00
+# define IOAPIC_WIN                 0x10
+# define IOAPIC_REG_ID              0x00
+# define IOAPIC_REG_VER             0x01
+# define IOAPIC_REG_REDTBL          0x10
+
+# define IOAPIC_ACTIVE_LOW          (1U << 13)
+# define IOAPIC_LEVEL               (1U << 15)
+# define IOAPIC_MASKED              (1U << 16)
+
+# define ISA_IRQS                   16
+# define MPS_POLARITY_MASK          0x3
+# define MPS_POLARITY_LOW           0x3
+# define MPS_TRIGGER_MASK           0xC
+# define MPS_TRIGGER_LEVEL          0xC
+
+typedef struct s_ioapic
+{
+    uint8_t             id;
+    uint8_t             entries;
+    uint32_t            gsi_base;
+    volatile uint32_t   *regs;
+}   t_ioapic;
+
+typedef struct s_isa_override
+{
+    uint32_t    gsi;
+    uint16_t    flags;
+}   t_isa_override;
+
+bool_t      apic_supported(void);
+bool_t      apic_enabled(void);
+int         apic_init(void);
+void        lapic_setup(void);
+
+uint32_t    lapic_read(uint32_t reg);
+void        lapic_write(uint32_t reg, uint32_t value);
+uint8_t     lapic_id(void);
+void        lapic_eoi(void);
+
+void        lapic_send_ipi(uint8_t apic_id, uint32_t icr_low);
+void        lapic_send_init(uint8_t apic_id);
+void        lapic_send_sipi(uint8_t apic_id, uint8_t page);
+void        lapic_send_vector(uint8_t apic_id, uint8_t vector);
+void        lapic_send_vector_others(uint8_t vector);
+void        lapic_send_nmi_others(void);
+
+int         lapic_timer_init(void);
+uint32_t    lapic_timer_khz(void);
+
+int         ioapic_add(uint8_t id, uint32_t phys, uint32_t gsi_base);
+void        ioapic_set_isa_override(uint8_t isa_irq, uint32_t gsi, uint16_t flags);
+uint32_t    ioapic_isa_to_gsi(uint8_t isa_irq);
+
+uint32_t    apic_spurious_count(void);
+void        apic_reset_spurious(void);
+
+extern const t_clockevent   g_lapic_clockevent;
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef ATOMIC_H
+# define ATOMIC_H
+
+# include "types.h"
+
+static ALWAYS_INLINE void barrier(void)
+{
+    __asm__ volatile ("" : : : "memory");
+}
+
+static ALWAYS_INLINE void smp_mb(void)
+{
+    __asm__ volatile ("lock; addl $0, (%%esp)" : : : "memory", "cc");
+}
+
+static ALWAYS_INLINE uint32_t atomic_cmpxchg(volatile uint32_t *ptr,
+                                             uint32_t old, uint32_t value)
+{
+    uint32_t prev;
+
+    __asm__ volatile ("lock; cmpxchgl %2, %1"
+                      : "=a"(prev), "+m"(*ptr)
+                      : "r"(value), "0"(old)
+                      : "memory", "cc");
+    return (prev);
+}
+
+static ALWAYS_INLINE uint32_t atomic_fetch_add(volatile uint32_t *ptr,
+                                               uint32_t value)
+{
+    __asm__ volatile ("lock; xaddl %0, %1"
+                      : "+r"(value), "+m"(*ptr)
+                      :
+                      : "memory", "cc");
+    return (value);
+}
+
+static ALWAYS_INLINE void atomic_inc(volatile uint32_t *ptr)
+{
+    __asm__ volatile ("lock; incl %0" : "+m"(*ptr) : : "memory", "cc");
+}
+
+static ALWAYS_INLINE void atomic_dec(volatile uint32_t *ptr)
+{
+    __asm__ volatile ("lock; decl %0" : "+m"(*ptr) : : "memory", "cc");
+}
+
+#endif
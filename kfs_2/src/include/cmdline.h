@@ -0,0 +1,12 @@
+#ifndef CMDLINE_H
+# define CMDLINE_H
+
+# include "types.h"
+# include "multiboot.h"
+
+# define CMDLINE_MAX            256
+
+void        cmdline_init(const t_multiboot_info *mbi);
+bool_t      cmdline_get(const char *key, char *value, size_t size);
+
+#endif
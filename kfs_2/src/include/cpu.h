@@ -0,0 +1,158 @@
+#ifndef CPU_H
+# define CPU_H
+
+# include "types.h"
+
+# define CPUID_FEAT_EDX_PSE     (1U << 3)
+# define CPUID_FEAT_EDX_TSC     (1U << 4)
+# define CPUID_FEAT_EDX_MSR     (1U << 5)
+# define CPUID_FEAT_EDX_PAE     (1U << 6)
+# define CPUID_FEAT_EDX_APIC    (1U << 9)
+# define CPUID_FEAT_EDX_PGE     (1U << 13)
+
+# define CPUID_EXT_EDX_NX       (1U << 20)
+# define CPUID_LEAF_POWER       0x80000007U
+# define CPUID_POWER_EDX_INVTSC (1U << 8)
+
+# define CR0_PG                 (1U << 31)
+# define CR0_WP                 (1U << 16)
+
+# define CR4_PSE                (1U << 4)
+# define CR4_PAE                (1U << 5)
+# define CR4_PGE                (1U << 7)
+
+# define EFLAGS_IF              (1U << 9)
+
+# define MSR_EFER               0xC0000080
+# define EFER_NXE               (1U << 11)
+
+typedef struct s_cpuid_regs
+{
+    uint32_t    eax;
+    uint32_t    ebx;
+    uint32_t    ecx;
+    uint32_t    edx;
+}   t_cpuid_regs;
+
+static ALWAYS_INLINE t_cpuid_regs cpuid(uint32_t leaf, uint32_t subleaf)
+{
+    t_cpuid_regs r;
+
+    __asm__ volatile ("cpuid"
+                      : "=a"(r.eax), "=b"(r.ebx), "=c"(r.ecx), "=d"(r.edx)
+                      : "a"(leaf), "c"(subleaf));
+    return (r);
+}
+
+static ALWAYS_INLINE uint32_t cpuid_max_extended(void)
+{
+    return (cpuid(0x80000000, 0).eax);
+}
+
+static ALWAYS_INLINE uint64_t rdmsr(uint32_t msr)
+{
+    uint32_t low;
+    uint32_t high;
+
+    __asm__ volatile ("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return (((uint64_t)high << 32) | low);
+}
+
+static ALWAYS_INLINE void wrmsr(uint32_t msr, uint64_t value)
+{
+    __asm__ volatile ("wrmsr"
+                      : : "c"(msr), "a"((uint32_t)value),
+                          "d"((uint32_t)(value >> 32)));
+}
+
+static ALWAYS_INLINE uint32_t read_cr0(void)
+{
+    uint32_t value;
+
+    __asm__ volatile ("mov %%cr0, %0" : "=r"(value));
+    return (value);
+}
+
+static ALWAYS_INLINE void write_cr0(uint32_t value)
+{
+    __asm__ volatile ("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+static ALWAYS_INLINE uint32_t read_cr2(void)
+{
+    uint32_t value;
+
+    __asm__ volatile ("mov %%cr2, %0" : "=r"(value));
+    return (value);
+}
+
+static ALWAYS_INLINE uint32_t read_cr3(void)
+{
+    uint32_t value;
+
+    __asm__ volatile ("mov %%cr3, %0" : "=r"(value));
+    return (value);
+}
+
+static ALWAYS_INLINE void write_cr3(uint32_t value)
+{
+    __asm__ volatile ("mov %0, %%cr3" : : "r"(value) : "memory");
+}
+
+static ALWAYS_INLINE uint32_t read_cr4(void)
+{
+    uint32_t value;
+
+    __asm__ volatile ("mov %%cr4, %0" : "=r"(value));
+    return (value);
+}
+
+static ALWAYS_INLINE void write_cr4(uint32_t value)
+{
+    __asm__ volatile ("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+static ALWAYS_INLINE uint64_t rdtsc(void)
+{
+    uint32_t lo;
+    uint32_t hi;
+
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return (((uint64_t)hi << 32) | lo);
+}
+
+static ALWAYS_INLINE uint32_t irq_save(void)
+{
+    uint32_t flags;
+
+    __asm__ volatile ("pushfl\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+    return (flags);
+}
+
+static ALWAYS_INLINE void irq_restore(uint32_t flags)
+{
+    if ((flags & EFLAGS_IF) != 0)
+    {
+        __asm__ volatile ("sti" : : : "memory");
+    }
+}
+
+static ALWAYS_INLINE bool_t irqs_disabled(void)
+{
+    uint32_t flags;
+
+    __asm__ volatile ("pushfl\n\tpop %0" : "=r"(flags));
+    return ((bool_t)((flags & EFLAGS_IF) == 0));
+}
+
+static ALWAYS_INLINE void cpu_relax(void)
+{
+    __asm__ volatile ("pause" : : : "memory");
+}
+
+static ALWAYS_INLINE void invlpg(uint32_t addr)
+{
+    __asm__ volatile ("invlpg (%0)" : : "r"(addr) : "memory");
+}
+
+#endif
@@ -5,7 +5,12 @@
 
 # define GDT_ADDRESS            0x00000800
 
-# define GDT_ENTRIES            7
+# define GDT_BASE_ENTRIES       7
+# define GDT_MAX_CPUS           16
+# define GDT_TSS_BASE           GDT_BASE_ENTRIES
+# define GDT_PERCPU_BASE        (GDT_TSS_BASE + GDT_MAX_CPUS)
+# define GDT_DF_TSS             (GDT_PERCPU_BASE + GDT_MAX_CPUS)
+# define GDT_ENTRIES            (GDT_DF_TSS + 1)
 
 # define GDT_NULL_SELECTOR      0x00
 # define GDT_KERNEL_CODE        0x08
@@ -14,6 +19,9 @@
 # define GDT_USER_CODE          0x20
 # define GDT_USER_DATA          0x28
 # define GDT_USER_STACK         0x30
+# define GDT_TSS_SELECTOR(cpu)  ((GDT_TSS_BASE + (cpu)) * 8)
+# define GDT_PERCPU_SELECTOR(cpu) ((GDT_PERCPU_BASE + (cpu)) * 8)
+# define GDT_DF_TSS_SELECTOR    (GDT_DF_TSS * 8)
 
 # define GDT_ACCESS_PRESENT     (1 << 7)
 # define GDT_ACCESS_RING0       (0 << 5)
@@ -28,6 +36,7 @@
 # define GDT_KERNEL_DATA_ACCESS 0x92
 # define GDT_USER_CODE_ACCESS   0xFA
 # define GDT_USER_DATA_ACCESS   0xF2
+# define GDT_TSS_ACCESS         0x89
 
 # define GDT_FLAG_GRANULARITY   (1 << 3)
 # define GDT_FLAG_32BIT         (1 << 2)
@@ -45,6 +54,37 @@ typedef struct PACKED s_gdt_entry
     uint8_t     base_high;
 }   t_gdt_entry;
 
+typedef struct PACKED s_tss
+{
+    uint32_t    prev_tss;
+    uint32_t    esp0;
+    uint32_t    ss0;
+    uint32_t    esp1;
+    uint32_t    ss1;
+    uint32_t    esp2;
+    uint32_t    ss2;
+    uint32_t    cr3;
+    uint32_t    eip;
+    uint32_t    eflags;
+    uint32_t    eax;
+    uint32_t    ecx;
+    uint32_t    edx;
+    uint32_t    ebx;
+    uint32_t    esp;
+    uint32_t    ebp;
+    uint32_t    esi;
+    uint32_t    edi;
+    uint32_t    es;
+    uint32_t    cs;
+    uint32_t    ss;
+    uint32_t    ds;
+    uint32_t    fs;
+    uint32_t    gs;
+    uint32_t    ldt;
+    uint16_t    trap;
+    uint16_t    iomap_base;
+}   t_tss;
+
 typedef struct PACKED s_gdt_ptr
 {
     uint16_t    limit;
@@ -56,6 +96,12 @@ void    gdt_init(void);
 void    gdt_set_entry(uint32_t index, uint32_t base, uint32_t limit,
                       uint8_t access, uint8_t flags);
 
+void    gdt_reload(void);
+
+void    gdt_load_tss(uint32_t cpu, t_tss *tss, uint32_t esp0);
+
+void    gdt_load_percpu(uint32_t cpu, uint32_t base, uint32_t size);
+
 void    gdt_print(void);
 
 extern void gdt_flush(uint32_t gdt_ptr);
@@ -0,0 +1,62 @@
+#ifndef HPET_H
+# define HPET_H
+
+# include "types.h"
+# include "tick.h"
+
+# define HPET_MMIO_SIZE         0x400
+
+# define HPET_GCAP_ID           0x000
+# define HPET_GEN_CONF          0x010
+# define HPET_GEN_INT_STS       0x020
+# define HPET_MAIN_CNT          0x0F0
+# define HPET_TN_CONF(n)        (0x100 + 0x20 * (n))
+# define HPET_TN_CMP(n)         (0x108 + 0x20 * (n))
+
+# define HPET_CAP_COUNT_64      (1U << 13)
+# define HPET_CAP_LEG_RT        (1U << 15)
+# define HPET_CAP_NUM_TIM(x)    ((((x) >> 8) & 0x1F) + 1)
+
+# define HPET_CONF_ENABLE       (1U << 0)
+# define HPET_CONF_LEG_RT       (1U << 1)
+
+# define HPET_TN_INT_ENB        (1U << 2)
+# define HPET_TN_TYPE_PERIODIC  (1U << 3)
+# define HPET_TN_PER_INT_CAP    (1U << 4)
+# define HPET_TN_VAL_SET        (1U << 6)
+# define HPET_TN_32MODE         (1U << 8)
+
+# define HPET_MAX_PERIOD_FS     100000000U
+# define HPET_FS_PER_NS         1000000U
+
+# define HPET_IRQ               0
+
+# define HPET_ONESHOT_MIN_NS    10000ULL
+# define HPET_ONESHOT_MAX_NS    1000000000ULL
+
+# define HPET_CALIBRATE_MS      10
+# define HPET_CALIBRATE_TRIALS  3
+
+typedef struct s_hpet_info
+{
+    bool_t      present;
+    bool_t      legacy_route;
+    bool_t      periodic;
+    bool_t      counter_64;
+    uint32_t    timers;
+    uint32_t    period_fs;
+    uint32_t    freq_khz;
+}   t_hpet_info;
+
+extern const t_clockevent   g_hpet_clockevent;
+
+int                 hpet_init(void);
+void                hpet_enable_clockevent(void);
+bool_t              hpet_available(void);
+const t_hpet_info   *hpet_get_info(void);
+uint32_t            hpet_read_counter(void);
+uint32_t            hpet_calibrate_tsc_khz(void);
+void                hpet_set_periodic(uint32_t hz);
+void                hpet_set_oneshot(uint64_t delta_ns);
+
+#endif
@@ -10,6 +10,9 @@
 #define IRQ_KEYBOARD        (IRQ_BASE + 1)
 #define IRQ_TIMER           (IRQ_BASE + 0)
 
+#define IRQ_STACK_SIZE      8192
+#define DF_STACK_SIZE       8192
+
 #define IDT_GATE_TASK       0x5
 #define IDT_GATE_INT16      0x6
 #define IDT_GATE_TRAP16     0x7
@@ -44,63 +47,66 @@ typedef struct s_interrupt_frame
     uint32_t    ss;
 }   t_interrupt_frame;
 
+typedef struct s_regs
+{
+    uint32_t    ds;
+    uint32_t    edi;
+    uint32_t    esi;
+    uint32_t    ebp;
+    uint32_t    esp_kernel;
+    uint32_t    ebx;
+    uint32_t    edx;
+    uint32_t    ecx;
+    uint32_t    eax;
+    uint32_t    vector;
+    uint32_t    err_code;
+    uint32_t    eip;
+    uint32_t    cs;
+    uint32_t    eflags;
+    uint32_t    esp;
+    uint32_t    ss;
+}   t_regs;
+
+#define IRQ_NONE            0
+#define IRQ_HANDLED         1
+
+#define EXCEPTION_COUNT     32
+#define EXCEPTION_DF        8
+#define IRQ_LINES           16
+#define INT_ACTION_POOL     64
+#define INT_STUB_SIZE       16
+
+#define INT_BENCH_VECTOR        0xF0
+#define INT_BENCH_LEGACY_VECTOR 0xF1
+#define INT_BENCH_DEFAULT_ITERS 10000
+
+typedef int (*t_int_handler)(t_regs *regs, void *ctx);
+
+typedef struct s_int_action
+{
+    t_int_handler           handler;
+    void                    *ctx;
+    struct s_int_action     *volatile next;
+}   t_int_action;
+
 void    idt_init(void);
 void    idt_set_gate(uint8_t num, uint32_t base, uint16_t sel, uint8_t flags);
 void    idt_load(void);
 
-extern void isr_stub_0(void);
-extern void isr_stub_1(void);
-extern void isr_stub_2(void);
-extern void isr_stub_3(void);
-extern void isr_stub_4(void);
-extern void isr_stub_5(void);
-extern void isr_stub_6(void);
-extern void isr_stub_7(void);
-extern void isr_stub_8(void);
-extern void isr_stub_9(void);
-extern void isr_stub_10(void);
-extern void isr_stub_11(void);
-extern void isr_stub_12(void);
-extern void isr_stub_13(void);
-extern void isr_stub_14(void);
-extern void isr_stub_15(void);
-extern void isr_stub_16(void);
-extern void isr_stub_17(void);
-extern void isr_stub_18(void);
-extern void isr_stub_19(void);
-extern void isr_stub_20(void);
-extern void isr_stub_21(void);
-extern void isr_stub_22(void);
-extern void isr_stub_23(void);
-extern void isr_stub_24(void);
-extern void isr_stub_25(void);
-extern void isr_stub_26(void);
-extern void isr_stub_27(void);
-extern void isr_stub_28(void);
-extern void isr_stub_29(void);
-extern void isr_stub_30(void);
-extern void isr_stub_31(void);
-
-extern void irq_stub_0(void);
-extern void irq_stub_1(void);
-extern void irq_stub_2(void);
-extern void irq_stub_3(void);
-extern void irq_stub_4(void);
-extern void irq_stub_5(void);
-extern void irq_stub_6(void);
-extern void irq_stub_7(void);
-extern void irq_stub_8(void);
-extern void irq_stub_9(void);
-extern void irq_stub_10(void);
-extern void irq_stub_11(void);
-extern void irq_stub_12(void);
-extern void irq_stub_13(void);
-extern void irq_stub_14(void);
-extern void irq_stub_15(void);
-
-extern void default_int_stub(void);
-
-void    isr_handler(void);
-void    irq_handler(uint32_t irq_num);
+extern uint8_t  int_stub_table[];
+extern void     int_stub_legacy(void);
+
+void    irq_stack_init(void);
+void    double_fault_init(void);
+
+int     int_register(uint8_t vector, t_int_handler handler, void *ctx);
+int     int_unregister(uint8_t vector, t_int_handler handler, void *ctx);
+int     irq_register(uint8_t irq, t_int_handler handler, void *ctx);
+int     exception_register(uint8_t vector, t_int_handler handler, void *ctx);
+
+void    isr_handler(t_regs *regs);
+void    irq_handler(t_regs *regs);
+
+void    int_benchmark(uint32_t iterations);
 
 #endif
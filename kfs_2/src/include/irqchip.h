@@ -0,0 +1,21 @@
+#ifndef IRQCHIP_H
+# define IRQCHIP_H
+
+# include "types.h"
+
+typedef struct s_irqchip
+{
+    const char  *name;
+    void        (*mask)(uint8_t irq);
+    void        (*unmask)(uint8_t irq);
+    void        (*eoi)(uint32_t vector);
+    bool_t      (*is_spurious)(uint32_t vector);
+}   t_irqchip;
+
+extern const t_irqchip  g_pic_chip;
+extern const t_irqchip  g_apic_chip;
+extern const t_irqchip  *g_irqchip;
+
+void    irqchip_init(void);
+
+#endif
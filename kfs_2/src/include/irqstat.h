@@ -0,0 +1,26 @@
+#ifndef IRQSTAT_H
+# define IRQSTAT_H
+
+# include "types.h"
+
+# define IRQSTAT_VECTORS        256
+# define IRQSTAT_BUCKETS        24
+# define IRQSTAT_BAR_WIDTH      40
+
+typedef struct s_irqstat
+{
+    uint32_t    seq;
+    uint32_t    count;
+    uint32_t    min;
+    uint32_t    max;
+    uint64_t    total;
+    uint32_t    hist[IRQSTAT_BUCKETS];
+}   t_irqstat;
+
+void                irqstat_record(uint32_t vector, uint64_t start, uint64_t end);
+void                irqstat_reset(void);
+void                irqstat_get(uint8_t vector, t_irqstat *out);
+void                irqstat_print(void);
+void                irqstat_print_vector(uint8_t vector);
+
+#endif
@@ -2,12 +2,14 @@
 #define KEYBOARD_H
 
 #include "types.h"
+#include "idt.h"
 
 #define KEYBOARD_DATA_PORT      0x60
 #define KEYBOARD_STATUS_PORT    0x64
 #define KEYBOARD_COMMAND_PORT   0x64
 
 #define KEYBOARD_BUFFER_SIZE    256
+#define KEYBOARD_RAW_SIZE       64
 
 #define KEY_ESC         0x01
 #define KEY_BACKSPACE   0x0E
@@ -46,12 +48,24 @@ typedef struct s_key_event
     uint8_t     scancode;
     char        ascii;
     bool_t      pressed;
+    uint64_t    irq_tsc;
 }   t_key_event;
 
+typedef struct s_kb_latency
+{
+    uint32_t    count;
+    uint64_t    min;
+    uint64_t    max;
+    uint64_t    total;
+}   t_kb_latency;
+
 void        keyboard_init(void);
-void        keyboard_handler(void);
+int         keyboard_handler(t_regs *regs, void *ctx);
 bool_t      keyboard_has_key(void);
 t_key_event keyboard_get_key(void);
+void        keyboard_wait(void);
+void        keyboard_print_latency(void);
+void        keyboard_reset_latency(void);
 char        keyboard_getchar(void);
 bool_t      keyboard_alt_pressed(void);
 
@@ -0,0 +1,21 @@
+#ifndef KTHREAD_H
+# define KTHREAD_H
+
+# include "types.h"
+# include "sched.h"
+
+# define KTHREAD_STACK_SIZE     8192
+
+# define KTHREAD_BENCH_DEFAULT_ITERS    10000
+
+typedef void (*t_kthread_fn)(void *arg);
+
+t_task      *kthread_create(const char *name, t_kthread_fn fn, void *arg);
+void        kthread_yield(void);
+void NORETURN kthread_exit(void);
+
+void        kthread_trampoline(void);
+
+void        kthread_benchmark(uint32_t iterations);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef KTIME_H
+# define KTIME_H
+
+# include "types.h"
+
+# define NSEC_PER_SEC           1000000000U
+# define NSEC_PER_MSEC          1000000U
+# define NSEC_PER_USEC          1000U
+
+typedef struct s_tsc_info
+{
+    bool_t      present;
+    bool_t      invariant;
+    uint32_t    khz;
+    uint32_t    mult;
+    uint32_t    shift;
+    uint64_t    base;
+    const char  *reference;
+}   t_tsc_info;
+
+void                tsc_init(void);
+const t_tsc_info    *tsc_get_info(void);
+void                tsc_set_khz(uint32_t khz);
+
+uint64_t            ktime_cycles(void);
+uint64_t            ktime_ns(void);
+uint64_t            cycles_to_ns(uint64_t cycles);
+
+#endif
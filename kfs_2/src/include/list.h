@@ -0,0 +1,67 @@
+#ifndef LIST_H
+# define LIST_H
+
+# include "types.h"
+
+typedef struct s_list
+{
+    struct s_list   *next;
+    struct s_list   *prev;
+}   t_list;
+
+# define LIST_INIT(name)                { &(name), &(name) }
+# define LIST_ENTRY(ptr, type, member)  \
+    ((type *)((uint8_t *)(ptr) - __builtin_offsetof(type, member)))
+
+static ALWAYS_INLINE void list_init(t_list *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static ALWAYS_INLINE bool_t list_empty(const t_list *head)
+{
+    return ((bool_t)(head->next == head));
+}
+
+static ALWAYS_INLINE void list_insert(t_list *node, t_list *prev, t_list *next)
+{
+    next->prev = node;
+    node->next = next;
+    node->prev = prev;
+    prev->next = node;
+}
+
+static ALWAYS_INLINE void list_add(t_list *node, t_list *head)
+{
+    list_insert(node, head, head->next);
+}
+
+static ALWAYS_INLINE void list_add_tail(t_list *node, t_list *head)
+{
+    list_insert(node, head->prev, head);
+}
+
+static ALWAYS_INLINE void list_del(t_list *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node;
+    node->prev = node;
+}
+
+static ALWAYS_INLINE void list_splice_init(t_list *from, t_list *to)
+{
+    if (list_empty(from))
+    {
+        list_init(to);
+        return;
+    }
+    to->next = from->next;
+    to->prev = from->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    list_init(from);
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define MOUSE_H
 
 #include "types.h"
+#include "idt.h"
 
 #define MOUSE_DATA_PORT         0x60
 #define MOUSE_STATUS_PORT       0x64
@@ -37,7 +38,7 @@ typedef struct s_mouse_event
 }   t_mouse_event;
 
 void        mouse_init(void);
-void        mouse_handler(void);
+int         mouse_handler(t_regs *regs, void *ctx);
 bool_t      mouse_has_event(void);
 t_mouse_event mouse_get_event(void);
 
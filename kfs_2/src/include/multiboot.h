@@ -0,0 +1,49 @@
+#ifndef MULTIBOOT_H
+# define MULTIBOOT_H
+
+# include "types.h"
+
+# define MULTIBOOT_BOOTLOADER_MAGIC     0x2BADB002
+
+# define MULTIBOOT_INFO_MEMORY          (1 << 0)
+# define MULTIBOOT_INFO_CMDLINE         (1 << 2)
+# define MULTIBOOT_INFO_MODS            (1 << 3)
+# define MULTIBOOT_INFO_MEM_MAP         (1 << 6)
+
+# define MULTIBOOT_MEMORY_AVAILABLE     1
+# define MULTIBOOT_MEMORY_RESERVED      2
+# define MULTIBOOT_MEMORY_ACPI          3
+# define MULTIBOOT_MEMORY_NVS           4
+# define MULTIBOOT_MEMORY_BADRAM        5
+
+typedef struct PACKED s_multiboot_info
+{
+    uint32_t    flags;
+    uint32_t    mem_lower;
+    uint32_t    mem_upper;
+    uint32_t    boot_device;
+    uint32_t    cmdline;
+    uint32_t    mods_count;
+    uint32_t    mods_addr;
+    uint32_t    syms[4];
+    uint32_t    mmap_length;
+    uint32_t    mmap_addr;
+}   t_multiboot_info;
+
+typedef struct PACKED s_multiboot_mmap_entry
+{
+    uint32_t    size;
+    uint64_t    addr;
+    uint64_t    len;
+    uint32_t    type;
+}   t_multiboot_mmap_entry;
+
+typedef struct PACKED s_multiboot_module
+{
+    uint32_t    mod_start;
+    uint32_t    mod_end;
+    uint32_t    cmdline;
+    uint32_t    reserved;
+}   t_multiboot_module;
+
+#endif
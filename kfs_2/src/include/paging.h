@@ -0,0 +1,68 @@
+#ifndef PAGING_H
+# define PAGING_H
+
+# include "types.h"
+# include "pmm.h"
+
+# define PAGE_PRESENT           0x001U
+# define PAGE_WRITE             0x002U
+# define PAGE_USER              0x004U
+# define PAGE_PWT               0x008U
+# define PAGE_PCD               0x010U
+# define PAGE_ACCESSED          0x020U
+# define PAGE_DIRTY             0x040U
+# define PAGE_LARGE             0x080U
+# define PAGE_GLOBAL            0x100U
+
+# if CONFIG_PAE
+typedef uint64_t                t_pte;
+#  define PAGE_NX               0x8000000000000000ULL
+#  define PAGE_ADDR_MASK        0x000FFFFFFFFFF000ULL
+#  define PAGING_PT_ENTRIES     512
+#  define PAGING_PD_SHIFT       21
+#  define PAGING_PDPT_ENTRIES   4
+# else
+typedef uint32_t                t_pte;
+#  define PAGE_NX               0U
+#  define PAGE_ADDR_MASK        0xFFFFF000U
+#  define PAGING_PT_ENTRIES     1024
+#  define PAGING_PD_SHIFT       22
+# endif
+
+# define PAGING_PD_ENTRIES      (1U << (32 - PAGING_PD_SHIFT))
+# define PAGING_LARGE_SIZE      (1U << PAGING_PD_SHIFT)
+
+# define MAP_WRITE              (1U << 0)
+# define MAP_NOEXEC             (1U << 1)
+# define MAP_NOCACHE            (1U << 2)
+# define MAP_GLOBAL             (1U << 3)
+
+# define MAP_KERNEL_DATA        (MAP_WRITE | MAP_NOEXEC | MAP_GLOBAL)
+# define MAP_MMIO               (MAP_WRITE | MAP_NOEXEC | MAP_NOCACHE)
+
+# define KMAP_BASE              0xFF800000U
+# define KMAP_SLOTS             16
+
+void        paging_init(void);
+
+int         paging_map(uint32_t virt, phys_addr_t phys, uint32_t flags);
+
+void        paging_unmap(uint32_t virt);
+
+bool_t      paging_is_mapped(uint32_t virt);
+
+phys_addr_t paging_virt_to_phys(uint32_t virt);
+
+void        *paging_map_mmio(phys_addr_t phys, uint32_t size);
+
+void        *paging_kmap(phys_addr_t frame);
+
+void        paging_kunmap(void *addr);
+
+bool_t      paging_enabled(void);
+
+bool_t      paging_nx_enabled(void);
+
+void        paging_print(void);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef PERCPU_H
+# define PERCPU_H
+
+# include "types.h"
+
+# define PERCPU_SELF            0
+# define PERCPU_CPU             4
+# define PERCPU_CURRENT         8
+# define PERCPU_IRQ_DEPTH       12
+# define PERCPU_IRQ_STACK_TOP   16
+# define PERCPU_NEED_RESCHED    20
+# define PERCPU_SOFTIRQ_PENDING 24
+# define TSS_TO_PERCPU          (16 * 8)
+
+# define PERCPU_ALIGN           64
+
+struct s_task;
+struct s_tasklet;
+
+typedef struct s_percpu
+{
+    struct s_percpu     *self;
+    uint32_t            cpu;
+    struct s_task       *current;
+    uint32_t            irq_depth;
+    uint32_t            irq_stack_top;
+    uint32_t            need_resched;
+    uint32_t            softirq_pending;
+    uint32_t            softirq_active;
+    uint32_t            bh_disable_count;
+    uint32_t            preempt_count;
+    uint32_t            irqs;
+    struct s_tasklet    *tasklet_head;
+    struct s_tasklet    **tasklet_tail;
+}   ALIGNED(PERCPU_ALIGN) t_percpu;
+
+STATIC_ASSERT(__builtin_offsetof(t_percpu, self) == PERCPU_SELF,
+              percpu_self_offset);
+STATIC_ASSERT(__builtin_offsetof(t_percpu, cpu) == PERCPU_CPU,
+              percpu_cpu_offset);
+STATIC_ASSERT(__builtin_offsetof(t_percpu, current) == PERCPU_CURRENT,
+              percpu_current_offset);
+STATIC_ASSERT(__builtin_offsetof(t_percpu, irq_depth) == PERCPU_IRQ_DEPTH,
+              percpu_irq_depth_offset);
+STATIC_ASSERT(__builtin_offsetof(t_percpu, irq_stack_top) ==
+              PERCPU_IRQ_STACK_TOP, percpu_irq_stack_top_offset);
+STATIC_ASSERT(__builtin_offsetof(t_percpu, need_resched) ==
+              PERCPU_NEED_RESCHED, percpu_need_resched_offset);
+STATIC_ASSERT(__builtin_offsetof(t_percpu, softirq_pending) ==
+              PERCPU_SOFTIRQ_PENDING, percpu_softirq_pending_offset);
+
+# define this_cpu_offset(field) __builtin_offsetof(t_percpu, field)
+
+# define this_cpu_read(field) \
+    __extension__ ({ \
+        __typeof__(((t_percpu *)0)->field) this_cpu_val_; \
+        __asm__ volatile ("movl %%gs:%c1, %0" \
+                          : "=r"(this_cpu_val_) \
+                          : "i"(this_cpu_offset(field))); \
+        this_cpu_val_; \
+    })
+
+# define this_cpu_write(field, value) \
+    __asm__ volatile ("movl %0, %%gs:%c1" \
+                      : : "ri"((uint32_t)(value)), \
+                          "i"(this_cpu_offset(field)) : "memory")
+
+# define this_cpu_inc(field) \
+    __asm__ volatile ("incl %%gs:%c0" \
+                      : : "i"(this_cpu_offset(field)) : "memory", "cc")
+
+# define this_cpu_dec(field) \
+    __asm__ volatile ("decl %%gs:%c0" \
+                      : : "i"(this_cpu_offset(field)) : "memory", "cc")
+
+# define this_cpu_or(field, mask) \
+    __asm__ volatile ("orl %0, %%gs:%c1" \
+                      : : "ri"((uint32_t)(mask)), \
+                          "i"(this_cpu_offset(field)) : "memory", "cc")
+
+# define this_cpu_ptr()         (this_cpu_read(self))
+
+void            percpu_init(uint32_t cpu);
+
+t_percpu        *percpu_get(uint32_t cpu);
+
+#endif
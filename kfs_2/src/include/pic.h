@@ -10,6 +10,11 @@
 
 #define PIC_EOI         0x20
 
+#define PIC_OCW3_READ_IRR   0x0A
+#define PIC_OCW3_READ_ISR   0x0B
+
+#define PIC_CASCADE_IRQ 2
+
 #define ICW1_ICW4       0x01
 #define ICW1_SINGLE     0x02
 #define ICW1_INTERVAL4  0x04
@@ -26,5 +31,10 @@ void    pic_init(void);
 void    pic_send_eoi(uint8_t irq);
 void    pic_set_mask(uint8_t irq);
 void    pic_clear_mask(uint8_t irq);
+void    pic_update_mask(uint16_t set_bits, uint16_t clear_bits);
+uint16_t pic_get_mask(void);
+bool_t  pic_is_spurious(uint8_t irq);
+uint32_t pic_spurious_count(uint8_t irq);
+void    pic_reset_spurious(void);
 
 #endif
@@ -0,0 +1,44 @@
+#ifndef PIT_H
+# define PIT_H
+
+# include "types.h"
+# include "tick.h"
+
+# define PIT_CHANNEL0           0x40
+# define PIT_CHANNEL2           0x42
+# define PIT_COMMAND            0x43
+# define PIT_PORT_B             0x61
+
+# define PIT_PORTB_GATE2        0x01
+# define PIT_PORTB_SPEAKER      0x02
+# define PIT_PORTB_OUT2         0x20
+
+# define PIT_BASE_FREQ          1193182U
+# define PIT_MIN_FREQ           19
+# define PIT_MAX_FREQ           PIT_BASE_FREQ
+
+# define PIT_CMD_CHANNEL0       0x00
+# define PIT_CMD_CHANNEL2       0x80
+# define PIT_CMD_LATCH          0x00
+# define PIT_CMD_LOHI           0x30
+# define PIT_CMD_MODE0          0x00
+# define PIT_CMD_MODE2          0x04
+
+# define PIT_IRQ                0
+
+# define PIT_ONESHOT_MIN_NS     1000ULL
+# define PIT_ONESHOT_MAX_NS     54900000ULL
+
+# define PIT_CALIBRATE_MS       10
+# define PIT_CALIBRATE_TRIALS   3
+
+extern const t_clockevent   g_pit_clockevent;
+
+void        pit_init(uint32_t hz);
+void        pit_set_periodic(uint32_t hz);
+void        pit_set_oneshot(uint64_t delta_ns);
+uint32_t    pit_frequency(void);
+uint16_t    pit_read_count(void);
+uint32_t    pit_calibrate_tsc_khz(void);
+
+#endif
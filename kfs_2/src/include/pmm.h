@@ -0,0 +1,49 @@
+#ifndef PMM_H
+# define PMM_H
+
+# include "types.h"
+# include "multiboot.h"
+
+# define PAGE_SIZE              4096
+# define PAGE_SHIFT             12
+# define PAGE_MASK              (PAGE_SIZE - 1)
+
+# if CONFIG_PAE
+#  define PMM_MAX_PHYS          0x1000000000ULL
+# else
+#  define PMM_MAX_PHYS          0x100000000ULL
+# endif
+
+# define PMM_LOWMEM_LIMIT       0xC0000000U
+# define PMM_RESERVED_LOW       0x00100000U
+
+# define PMM_MAX_REGIONS        32
+
+typedef struct s_pmm_region
+{
+    uint64_t    base;
+    uint64_t    length;
+    uint32_t    type;
+}   t_pmm_region;
+
+void        pmm_init(const t_multiboot_info *mbi);
+
+phys_addr_t pmm_alloc_frame(void);
+
+phys_addr_t pmm_alloc_frame_high(void);
+
+void        pmm_free_frame(phys_addr_t frame);
+
+void        pmm_reserve_range(uint64_t base, uint64_t length);
+
+uint32_t    pmm_release_range(uint64_t base, uint64_t length);
+
+uint32_t    pmm_free_frames(void);
+
+uint32_t    pmm_total_frames(void);
+
+uint32_t    pmm_lowmem_end(void);
+
+void        pmm_print(void);
+
+#endif
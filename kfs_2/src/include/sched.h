@@ -0,0 +1,111 @@
+#ifndef SCHED_H
+# define SCHED_H
+
+# include "types.h"
+# include "list.h"
+# include "time.h"
+# include "timer.h"
+# include "percpu.h"
+
+# define TASK_MAX               16
+# define TASK_NAME_LEN          16
+
+# define TASK_UNUSED            0
+# define TASK_RUNNING           1
+# define TASK_READY             2
+# define TASK_BLOCKED           3
+# define TASK_DEAD              4
+
+# define SCHED_PRIO_LEVELS      32
+# define SCHED_PRIO_MAX         0
+# define SCHED_PRIO_DEFAULT     16
+# define SCHED_PRIO_IDLE        (SCHED_PRIO_LEVELS - 1)
+
+# define SCHED_SLICE_MAX_MS     100
+# define SCHED_SLICE_MIN_MS     5
+
+# define SCHED_NORMAL           0
+# define SCHED_DEADLINE         1
+
+# define SCHED_DL_BW_SHIFT      20
+# define SCHED_DL_BW_LIMIT      ((95U << SCHED_DL_BW_SHIFT) / 100)
+# define SCHED_DL_MAX_PERIOD_NS 1000000000ULL
+
+# define DL_BENCH_DEFAULT_JOBS  100
+# define DL_BENCH_RUNTIME_NS    2000000ULL
+# define DL_BENCH_WORK_NS       1000000ULL
+# define DL_BENCH_PERIOD_NS     20000000ULL
+
+typedef struct s_task
+{
+    uint32_t    esp;
+    uint32_t    pid;
+    uint32_t    state;
+    uint32_t    prio;
+    char        name[TASK_NAME_LEN];
+    uint32_t    stack_base;
+    uint32_t    slice;
+    uint32_t    switches;
+    uint64_t    runtime;
+    uint64_t    last_run;
+    t_list      run_node;
+    uint32_t    policy;
+    uint32_t    dl_bw;
+    uint64_t    dl_runtime;
+    uint64_t    dl_deadline;
+    uint64_t    dl_period;
+    uint64_t    dl_abs_deadline;
+    uint64_t    dl_budget;
+    uint64_t    dl_exec_start;
+    uint64_t    dl_release;
+    bool_t      dl_throttled;
+    bool_t      dl_overrun;
+    bool_t      dl_wakeup_pending;
+    uint32_t    dl_jobs;
+    uint32_t    dl_misses;
+    t_timer     dl_timer;
+}   t_task;
+
+static ALWAYS_INLINE t_task *current_task(void)
+{
+    return (this_cpu_read(current));
+}
+
+void        sched_init(const char *name);
+t_task      *task_alloc(const char *name);
+t_task      *task_get(uint32_t index);
+void        sched_enqueue(t_task *task);
+void        sched_dequeue(t_task *task);
+void        sched_set_priority(t_task *task, uint32_t prio);
+void        sched_block(void);
+void        sched_wakeup(t_task *task);
+void        schedule(void);
+void        schedule_tail(void);
+void NORETURN sched_exit(void);
+void        preempt_schedule_irq(void);
+void        sched_tick(void);
+uint32_t    sched_switch_count(void);
+uint32_t    sched_timeslice(uint32_t prio);
+const char  *task_state_name(uint32_t state);
+void        sched_print_tasks(void);
+
+int         sched_setattr_dl(t_task *task, uint64_t runtime_ns,
+                             uint64_t deadline_ns, uint64_t period_ns);
+void        sched_dl_yield(void);
+uint32_t    sched_dl_bandwidth(void);
+void        dl_enqueue(t_task *task);
+void        dl_dequeue(t_task *task);
+t_task      *dl_pick(void);
+bool_t      dl_has_ready(void);
+void        dl_charge(t_task *task, uint64_t now);
+void        dl_put_prev(t_task *task, uint64_t now);
+void        dl_activate(t_task *task, uint64_t now);
+void        dl_release(t_task *task);
+void        dl_benchmark(uint32_t jobs);
+
+void        preempt_disable(void);
+void        preempt_enable(void);
+
+void        switch_to(uint32_t *prev_esp, uint32_t next_esp);
+
+#endif
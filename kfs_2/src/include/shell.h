@@ -32,6 +32,8 @@ int     cmd_help(int argc, char **argv);
 
 int     cmd_stack(int argc, char **argv);
 
+int     cmd_stackuse(int argc, char **argv);
+
 int     cmd_gdt(int argc, char **argv);
 
 int     cmd_reboot(int argc, char **argv);
@@ -44,4 +46,34 @@ int     cmd_info(int argc, char **argv);
 
 int     cmd_regs(int argc, char **argv);
 
+int     cmd_mem(int argc, char **argv);
+
+int     cmd_irqstat(int argc, char **argv);
+
+int     cmd_acpi(int argc, char **argv);
+
+int     cmd_intbench(int argc, char **argv);
+
+int     cmd_uptime(int argc, char **argv);
+
+int     cmd_idlestat(int argc, char **argv);
+
+int     cmd_timerbench(int argc, char **argv);
+
+int     cmd_ctxbench(int argc, char **argv);
+
+int     cmd_ps(int argc, char **argv);
+
+int     cmd_dlbench(int argc, char **argv);
+
+int     cmd_kbdlat(int argc, char **argv);
+
+int     cmd_cpus(int argc, char **argv);
+
+int     cmd_parbench(int argc, char **argv);
+
+int     cmd_lockstat(int argc, char **argv);
+
+int     cmd_ipibench(int argc, char **argv);
+
 #endif
@@ -0,0 +1,121 @@
+#ifndef SMP_H
+# define SMP_H
+
+# include "types.h"
+# include "gdt.h"
+# include "percpu.h"
+# include "spinlock.h"
+
+# define SMP_MAX_CPUS           GDT_MAX_CPUS
+# define SMP_STACK_SIZE         8192
+
+# define SMP_TRAMPOLINE_BASE    0x00008000U
+# define SMP_INIT_DELAY_US      10000
+# define SMP_SIPI_DELAY_US      200
+# define SMP_BOOT_TIMEOUT_US    1000000
+# define SMP_STOP_TIMEOUT_US    100000
+
+# define SMP_IPI_CALL_VECTOR    0xF2
+# define SMP_IPI_RESCHED_VECTOR 0xF3
+# define SMP_NMI_VECTOR         2
+
+# define SMP_CALL_QUEUE_SIZE    64
+# define SMP_CALL_QUEUE_MASK    (SMP_CALL_QUEUE_SIZE - 1)
+
+# define SMP_IPI_BENCH_DEFAULT  1000
+# define SMP_IPI_BENCH_MAX      100000
+# define SMP_IPI_BENCH_BATCH    32
+
+# define SMP_CPU(cpu)           (1U << (cpu))
+# define SMP_ALL_CPUS           0xFFFFFFFFU
+# define SMP_WORK_CLAIMED       1U
+
+typedef void (*t_smp_fn)(void *arg);
+
+typedef uint32_t t_cpumask;
+
+STATIC_ASSERT(SMP_MAX_CPUS < sizeof(t_cpumask) * 8, smp_cpumask_width);
+
+typedef struct PACKED s_trampoline
+{
+    uint32_t    cr3;
+    uint32_t    cr4;
+    uint32_t    cr0;
+    uint32_t    efer_nx;
+    uint32_t    stack;
+    uint32_t    entry;
+    uint32_t    cpu;
+}   t_trampoline;
+
+typedef struct s_cpu
+{
+    uint32_t            id;
+    uint8_t             apic_id;
+    uint8_t             acpi_id;
+    volatile bool_t     online;
+    volatile bool_t     stopped;
+    volatile bool_t     idle;
+    char                name[8];
+    char                irq_name[8];
+    uint32_t            stack;
+    uint32_t            irq_stack;
+    uint64_t            boot_cycles;
+    t_tss               tss;
+    volatile t_smp_fn   work_fn;
+    void *volatile      work_arg;
+    volatile uint32_t   jobs;
+}   t_cpu;
+
+typedef struct s_smp_call
+{
+    t_smp_fn            fn;
+    void                *arg;
+    volatile uint32_t   *pending;
+}   t_smp_call;
+
+typedef struct s_smp_callq
+{
+    t_spinlock          lock;
+    uint32_t            head;
+    uint32_t            tail;
+    t_smp_call          calls[SMP_CALL_QUEUE_SIZE];
+    uint32_t            queued;
+    uint32_t            kicks;
+    uint32_t            run;
+    uint32_t            ipis;
+}   ALIGNED(PERCPU_ALIGN) t_smp_callq;
+
+extern uint8_t  trampoline_start[];
+extern uint8_t  trampoline_params[];
+extern uint8_t  trampoline_end[];
+
+void            smp_init(void);
+
+uint32_t        smp_cpu_count(void);
+
+uint32_t        smp_online_count(void);
+
+uint32_t        smp_processor_id(void);
+
+const t_cpu     *smp_get_cpu(uint32_t cpu);
+
+int             smp_run_on(uint32_t cpu, t_smp_fn fn, void *arg);
+
+void            smp_wait(uint32_t cpu);
+
+int             smp_call_function(t_cpumask mask, t_smp_fn fn, void *arg,
+                                  bool_t wait);
+
+void            smp_send_reschedule(uint32_t cpu);
+
+void            smp_kick_idle(void);
+
+void            smp_stop_others(void);
+
+void            smp_tlb_shootdown(uint32_t virt);
+
+void            smp_ipi_benchmark(uint32_t iterations);
+
+void            smp_print(void);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef SOFTIRQ_H
+# define SOFTIRQ_H
+
+# include "types.h"
+
+# define SOFTIRQ_TIMER          0
+# define SOFTIRQ_TASKLET        1
+# define SOFTIRQ_COUNT          2
+
+# define SOFTIRQ_MAX_RESTART    10
+
+# define TASKLET_SCHEDULED      (1U << 0)
+
+typedef void (*t_softirq_handler)(void);
+
+typedef struct s_tasklet
+{
+    struct s_tasklet    *next;
+    void                (*func)(void *data);
+    void                *data;
+    volatile uint32_t   state;
+    uint32_t            runs;
+}   t_tasklet;
+
+# define TASKLET_INIT(fn, arg)  { NULL, (fn), (arg), 0, 0 }
+
+void        softirq_init(void);
+void        softirq_register(uint32_t nr, t_softirq_handler handler);
+void        raise_softirq(uint32_t nr);
+void        do_softirq(void);
+void        softirq_run_pending(void);
+uint32_t    softirq_runs(uint32_t nr);
+
+bool_t      in_softirq(void);
+void        local_bh_disable(void);
+void        local_bh_enable(void);
+
+void        tasklet_schedule(t_tasklet *tasklet);
+
+void        softirq_print(void);
+
+#endif
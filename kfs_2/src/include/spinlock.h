@@ -0,0 +1,259 @@
+#ifndef SPINLOCK_H
+# define SPINLOCK_H
+
+# include "types.h"
+# include "atomic.h"
+# include "cpu.h"
+# include "sched.h"
+# include "softirq.h"
+
+# ifndef CONFIG_LOCKSTAT
+#  define CONFIG_LOCKSTAT       0
+# endif
+
+# define LOCKSTAT_MAX           32
+
+# define RWLOCK_WRITER          0x80000000U
+# define RWLOCK_WAITING         0x40000000U
+
+typedef struct s_lockstat
+{
+    const char          *name;
+    volatile uint32_t   registered;
+    uint32_t            acquisitions;
+    uint32_t            contended;
+    volatile uint32_t   reads;
+    volatile uint32_t   read_contended;
+    uint64_t            wait_cycles;
+    uint64_t            wait_max;
+    uint64_t            hold_cycles;
+    uint64_t            hold_max;
+    uint64_t            hold_start;
+}   t_lockstat;
+
+typedef struct s_spinlock
+{
+    volatile uint32_t   next;
+    volatile uint32_t   owner;
+# if CONFIG_LOCKSTAT
+    t_lockstat          stat;
+# endif
+}   t_spinlock;
+
+typedef struct s_rwlock
+{
+    volatile uint32_t   state;
+# if CONFIG_LOCKSTAT
+    t_lockstat          stat;
+# endif
+}   t_rwlock;
+
+# if CONFIG_LOCKSTAT
+#  define LOCKSTAT_INIT(lockname) \
+    , { (lockname), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+#  define LOCKSTAT_ACQUIRED(lock, contended, wait) \
+    lockstat_acquired(&(lock)->stat, (contended), (wait))
+#  define LOCKSTAT_RELEASED(lock)   lockstat_released(&(lock)->stat)
+#  define LOCKSTAT_READ(lock, contended) \
+    lockstat_read(&(lock)->stat, (contended))
+# else
+#  define LOCKSTAT_INIT(lockname)
+#  define LOCKSTAT_ACQUIRED(lock, contended, wait)  ((void)0)
+#  define LOCKSTAT_RELEASED(lock)                   ((void)0)
+#  define LOCKSTAT_READ(lock, contended)            ((void)0)
+# endif
+
+# define SPINLOCK_INIT(name)    { 0, 0 LOCKSTAT_INIT(name) }
+# define RWLOCK_INIT(name)      { 0 LOCKSTAT_INIT(name) }
+
+void        spin_lock_init(t_spinlock *lock, const char *name);
+void        spin_lock_slow(t_spinlock *lock, uint32_t ticket);
+void        read_lock_slow(t_rwlock *lock);
+void        write_lock_slow(t_rwlock *lock);
+
+# if CONFIG_LOCKSTAT
+
+void        lockstat_acquired(t_lockstat *stat, bool_t contended,
+                              uint64_t wait);
+void        lockstat_released(t_lockstat *stat);
+void        lockstat_read(t_lockstat *stat, bool_t contended);
+
+# endif
+
+void        lockstat_reset(void);
+
+void        lockstat_print(void);
+
+static ALWAYS_INLINE void spin_acquire(t_spinlock *lock)
+{
+    uint32_t    ticket;
+
+    ticket = atomic_fetch_add(&lock->next, 1);
+    if (lock->owner != ticket)
+    {
+        spin_lock_slow(lock, ticket);
+        return;
+    }
+    LOCKSTAT_ACQUIRED(lock, FALSE, 0);
+}
+
+static ALWAYS_INLINE void spin_release(t_spinlock *lock)
+{
+    LOCKSTAT_RELEASED(lock);
+    barrier();
+    lock->owner = lock->owner + 1;
+}
+
+static ALWAYS_INLINE void spin_lock(t_spinlock *lock)
+{
+    preempt_disable();
+    spin_acquire(lock);
+}
+
+static ALWAYS_INLINE void spin_unlock(t_spinlock *lock)
+{
+    spin_release(lock);
+    preempt_enable();
+}
+
+static ALWAYS_INLINE bool_t spin_trylock(t_spinlock *lock)
+{
+    uint32_t    owner;
+
+    preempt_disable();
+    owner = lock->owner;
+    if (lock->next != owner ||
+        atomic_cmpxchg(&lock->next, owner, owner + 1) != owner)
+    {
+        preempt_enable();
+        return (FALSE);
+    }
+    LOCKSTAT_ACQUIRED(lock, FALSE, 0);
+    return (TRUE);
+}
+
+static ALWAYS_INLINE bool_t spin_is_locked(const t_spinlock *lock)
+{
+    return ((bool_t)(lock->next != lock->owner));
+}
+
+static ALWAYS_INLINE uint32_t spin_lock_irqsave(t_spinlock *lock)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    spin_acquire(lock);
+    return (flags);
+}
+
+static ALWAYS_INLINE void spin_unlock_irqrestore(t_spinlock *lock,
+                                                 uint32_t flags)
+{
+    spin_release(lock);
+    irq_restore(flags);
+}
+
+static ALWAYS_INLINE void spin_lock_bh(t_spinlock *lock)
+{
+    local_bh_disable();
+    spin_acquire(lock);
+}
+
+static ALWAYS_INLINE void spin_unlock_bh(t_spinlock *lock)
+{
+    spin_release(lock);
+    local_bh_enable();
+}
+
+static ALWAYS_INLINE void read_acquire(t_rwlock *lock)
+{
+    uint32_t    state;
+
+    state = lock->state;
+    if ((state & (RWLOCK_WRITER | RWLOCK_WAITING)) == 0 &&
+        atomic_cmpxchg(&lock->state, state, state + 1) == state)
+    {
+        LOCKSTAT_READ(lock, FALSE);
+        return;
+    }
+    read_lock_slow(lock);
+}
+
+static ALWAYS_INLINE void read_release(t_rwlock *lock)
+{
+    atomic_dec(&lock->state);
+}
+
+static ALWAYS_INLINE void write_acquire(t_rwlock *lock)
+{
+    if (atomic_cmpxchg(&lock->state, 0, RWLOCK_WRITER) != 0)
+    {
+        write_lock_slow(lock);
+        return;
+    }
+    LOCKSTAT_ACQUIRED(lock, FALSE, 0);
+}
+
+static ALWAYS_INLINE void write_release(t_rwlock *lock)
+{
+    LOCKSTAT_RELEASED(lock);
+    atomic_fetch_add(&lock->state, 0U - RWLOCK_WRITER);
+}
+
+static ALWAYS_INLINE void read_lock(t_rwlock *lock)
+{
+    preempt_disable();
+    read_acquire(lock);
+}
+
+static ALWAYS_INLINE void read_unlock(t_rwlock *lock)
+{
+    read_release(lock);
+    preempt_enable();
+}
+
+static ALWAYS_INLINE void write_lock(t_rwlock *lock)
+{
+    preempt_disable();
+    write_acquire(lock);
+}
+
+static ALWAYS_INLINE void write_unlock(t_rwlock *lock)
+{
+    write_release(lock);
+    preempt_enable();
+}
+
+static ALWAYS_INLINE uint32_t read_lock_irqsave(t_rwlock *lock)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    read_acquire(lock);
+    return (flags);
+}
+
+static ALWAYS_INLINE void read_unlock_irqrestore(t_rwlock *lock,
+                                                 uint32_t flags)
+{
+    read_release(lock);
+    irq_restore(flags);
+}
+
+static ALWAYS_INLINE uint32_t write_lock_irqsave(t_rwlock *lock)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    write_acquire(lock);
+    return (flags);
+}
+
+static ALWAYS_INLINE void write_unlock_irqrestore(t_rwlock *lock,
+                                                  uint32_t flags)
+{
+    write_release(lock);
+    irq_restore(flags);
+}
+
+#endif
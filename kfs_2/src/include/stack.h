@@ -3,12 +3,29 @@
 
 # include "types.h"
 
+# define STACK_PAINT_PATTERN    0x57AC57AC
+
+# define STACK_MAX_REGIONS      32
+
+# define STACK_AREA_BASE        0xE0000000U
+# define STACK_AREA_SLOT_SIZE   0x10000U
+# define STACK_AREA_SLOTS       256
+
 typedef struct s_stack_frame
 {
     struct s_stack_frame    *ebp;
     uint32_t                eip;
 }   t_stack_frame;
 
+typedef struct s_stack_region
+{
+    const char  *name;
+    uint32_t    base;
+    uint32_t    size;
+    bool_t      guarded;
+    bool_t      owned;
+}   t_stack_region;
+
 typedef struct s_registers
 {
     uint32_t    eax;
@@ -45,4 +62,23 @@ uint32_t    stack_get_eip(void);
 
 uint32_t    stack_get_eflags(void);
 
+void        stack_init(void);
+
+void        stack_paint(uint32_t base, uint32_t size);
+
+uint32_t    stack_high_water(uint32_t base, uint32_t size);
+
+int         stack_register(const char *name, uint32_t base, uint32_t size,
+                           bool_t guarded);
+
+void        stack_unregister(uint32_t base);
+
+uint32_t    stack_alloc(const char *name, uint32_t size);
+
+void        stack_free(uint32_t base);
+
+const t_stack_region    *stack_find(uint32_t addr);
+
+void        stack_print_usage(void);
+
 #endif
@@ -0,0 +1,44 @@
+#ifndef TICK_H
+# define TICK_H
+
+# include "types.h"
+# include "time.h"
+
+# define TICK_NSEC              (1000000000U / HZ)
+
+# define CLOCK_EVT_PERIODIC     0
+# define CLOCK_EVT_ONESHOT      1
+
+typedef struct s_clockevent
+{
+    const char  *name;
+    uint64_t    min_delta_ns;
+    uint64_t    max_delta_ns;
+    void        (*set_periodic)(uint32_t hz);
+    void        (*set_oneshot)(uint64_t delta_ns);
+}   t_clockevent;
+
+typedef struct s_idle_stats
+{
+    uint32_t    entries;
+    uint32_t    wakeups;
+    uint32_t    timer_irqs;
+    uint32_t    wakeups_last_sec;
+    uint32_t    timer_irqs_last_sec;
+    uint32_t    window_wakeups;
+    uint32_t    window_timer_irqs;
+    uint64_t    window_start_ns;
+    uint64_t    sleep_ns;
+    uint64_t    longest_sleep_ns;
+}   t_idle_stats;
+
+void                tick_init(const t_clockevent *clockevent);
+void                tick_handle(void);
+uint32_t            tick_mode(void);
+const t_clockevent  *tick_clockevent(void);
+
+void                cpu_idle(void);
+
+void                idle_print_stats(void);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef TIME_H
+# define TIME_H
+
+# include "types.h"
+
+# ifndef CONFIG_HZ
+#  define CONFIG_HZ             100
+# endif
+
+# define HZ                     CONFIG_HZ
+
+# define TIME_NO_EXPIRY         0xFFFFFFFFFFFFFFFFULL
+
+extern volatile uint64_t    g_jiffies;
+
+void        time_init(void);
+void        time_tick(uint32_t ticks);
+uint64_t    jiffies_get(void);
+uint64_t    jiffies_to_ms(uint64_t jiffies);
+void        time_print_uptime(void);
+
+#endif
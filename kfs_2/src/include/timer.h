@@ -0,0 +1,41 @@
+#ifndef TIMER_H
+# define TIMER_H
+
+# include "types.h"
+# include "list.h"
+
+# define TVR_BITS               8
+# define TVN_BITS               6
+# define TVR_SIZE               (1U << TVR_BITS)
+# define TVN_SIZE               (1U << TVN_BITS)
+# define TVR_MASK               (TVR_SIZE - 1)
+# define TVN_MASK               (TVN_SIZE - 1)
+# define TVN_LEVELS             4
+
+# define TIMER_MAX_DELTA        0xFFFFFFFFULL
+
+# define TIMER_BENCH_DEFAULT    100000
+
+typedef struct s_timer
+{
+    t_list      entry;
+    uint64_t    expires;
+    void        (*func)(void *data);
+    void        *data;
+    bool_t      pending;
+}   t_timer;
+
+# define TIMER_INIT(fn, arg)    { { NULL, NULL }, 0, (fn), (arg), FALSE }
+
+void        timers_init(void);
+void        timer_setup(t_timer *timer, void (*func)(void *data), void *data);
+void        add_timer(t_timer *timer);
+int         del_timer(t_timer *timer);
+int         mod_timer(t_timer *timer, uint64_t expires);
+bool_t      timer_pending(const t_timer *timer);
+uint64_t    timer_next_expiry(void);
+uint32_t    timer_count(void);
+
+void        timer_benchmark(uint32_t count);
+
+#endif
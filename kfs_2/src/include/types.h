@@ -18,6 +18,16 @@ typedef int32_t             intptr_t;
 
 typedef uint8_t             bool_t;
 
+#ifndef CONFIG_PAE
+# define CONFIG_PAE         0
+#endif
+
+#if CONFIG_PAE
+typedef uint64_t            phys_addr_t;
+#else
+typedef uint32_t            phys_addr_t;
+#endif
+
 #define TRUE                ((bool_t)1)
 #define FALSE               ((bool_t)0)
 
@@ -29,6 +39,10 @@ typedef uint8_t             bool_t;
 #define UNUSED              __attribute__((unused))
 #define ALWAYS_INLINE       __attribute__((always_inline)) inline
 
+#define __init              __attribute__((section(".init.text"), cold, noinline))
+#define __initdata          __attribute__((section(".init.data")))
+#define __initconst         __attribute__((section(".init.rodata")))
+
 #define STATIC_ASSERT(cond, msg) \
     typedef char static_assertion_##msg[(cond) ? 1 : -1]
 
@@ -0,0 +1,47 @@
+#ifndef WAIT_H
+# define WAIT_H
+
+# include "types.h"
+# include "list.h"
+# include "sched.h"
+# include "cpu.h"
+
+typedef struct s_wait_queue
+{
+    t_list      head;
+    uint32_t    wakeups;
+}   t_wait_queue;
+
+typedef struct s_wait_entry
+{
+    t_list      node;
+    t_task      *task;
+}   t_wait_entry;
+
+# define WAIT_QUEUE_INIT(name)  { LIST_INIT((name).head), 0 }
+
+# define wait_event(wq, condition)                  \
+    do {                                            \
+        t_wait_entry    wait_entry__;               \
+        uint32_t        wait_flags__;               \
+                                                    \
+        wait_flags__ = irq_save();                  \
+        wait_entry_init(&wait_entry__);             \
+        while (!(condition))                        \
+        {                                           \
+            prepare_to_wait((wq), &wait_entry__);   \
+            sched_block();                          \
+        }                                           \
+        finish_wait((wq), &wait_entry__);           \
+        irq_restore(wait_flags__);                  \
+    } while (0)
+
+void        wait_queue_init(t_wait_queue *wq);
+void        wait_entry_init(t_wait_entry *entry);
+void        prepare_to_wait(t_wait_queue *wq, t_wait_entry *entry);
+void        finish_wait(t_wait_queue *wq, t_wait_entry *entry);
+uint32_t    wake_up_nr(t_wait_queue *wq, uint32_t nr);
+uint32_t    wake_up(t_wait_queue *wq);
+bool_t      wait_queue_active(const t_wait_queue *wq);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef WORKQ_H
+# define WORKQ_H
+
+# include "types.h"
+# include "percpu.h"
+
+# define WORKQ_SIZE             1024
+# define WORKQ_MASK             (WORKQ_SIZE - 1)
+
+# define WORKQ_BENCH_DEFAULT    256
+# define WORKQ_BENCH_MAX        WORKQ_SIZE
+# define WORKQ_BENCH_SPIN       100000
+
+typedef void (*t_work_fn)(void *arg);
+
+typedef struct s_work
+{
+    t_work_fn   fn;
+    void        *arg;
+    uint32_t    cpu;
+}   t_work;
+
+typedef struct s_workq
+{
+    volatile uint32_t   top ALIGNED(PERCPU_ALIGN);
+    volatile uint32_t   bottom ALIGNED(PERCPU_ALIGN);
+    t_work *volatile    slots[WORKQ_SIZE];
+    uint32_t            executed;
+    uint32_t            migrations;
+    uint32_t            steals;
+    uint32_t            stolen;
+    uint32_t            aborts;
+}   t_workq;
+
+int         workq_push(t_work *work);
+
+bool_t      workq_run_one(void);
+
+bool_t      workq_has_work(void);
+
+uint32_t    workq_pending(uint32_t cpu);
+
+void        workq_reset_stats(void);
+
+void        workq_print_stats(void);
+
+void        workq_benchmark(uint32_t jobs);
+
+#endif
@@ -0,0 +1,340 @@
+#include "kernel.h"
+#include "../include/acpi.h"
+#include "../include/apic.h"
+#include "../include/pmm.h"
+#include "../include/paging.h"
+#include "../lib/string.h"
+
+static t_acpi_info  g_acpi;
+
+static bool_t acpi_checksum_ok(const void *ptr, uint32_t length)
+{
+    const uint8_t   *bytes;
+    uint8_t         sum;
+    uint32_t        i;
+
+    bytes = (const uint8_t *)ptr;
+    sum = 0;
+    for (i = 0; i < length; i++)
+    {
+        sum = (uint8_t)(sum + bytes[i]);
+    }
+    return ((bool_t)(sum == 0));
+}
+
+static const t_acpi_rsdp *__init acpi_scan_rsdp(uint32_t start, uint32_t length)
+{
+    const t_acpi_rsdp   *rsdp;
+    uint32_t            addr;
+
+    for (addr = start; addr + sizeof(t_acpi_rsdp) <= start + length; addr += 16)
+    {
+        rsdp = (const t_acpi_rsdp *)addr;
+        if (k_memcmp(rsdp->signature, ACPI_RSDP_SIGNATURE, 8) != 0 ||
+            !acpi_checksum_ok(rsdp, 20))
+        {
+            continue;
+        }
+        if (rsdp->revision >= 2 &&
+            (rsdp->length < sizeof(t_acpi_rsdp) ||
+             !acpi_checksum_ok(rsdp, rsdp->length)))
+        {
+            continue;
+        }
+        return (rsdp);
+    }
+    return (NULL);
+}
+
+static const t_acpi_rsdp *__init acpi_find_rsdp(void)
+{
+    const t_acpi_rsdp   *rsdp;
+    uintptr_t           ebda_ptr;
+    uint32_t            ebda;
+
+    ebda_ptr = ACPI_EBDA_PTR;
+    __asm__ ("" : "+r"(ebda_ptr));
+    ebda = (uint32_t)(*(const volatile uint16_t *)ebda_ptr) << 4;
+    if (ebda >= 0x80000 && ebda < 0xA0000)
+    {
+        rsdp = acpi_scan_rsdp(ebda, 1024);
+        if (rsdp != NULL)
+        {
+            return (rsdp);
+        }
+    }
+    return (acpi_scan_rsdp(ACPI_BIOS_START, ACPI_BIOS_END - ACPI_BIOS_START));
+}
+
+static const t_acpi_header *__init acpi_map_table(uint32_t phys)
+{
+    const t_acpi_header *header;
+    uint32_t            length;
+
+    header = (const t_acpi_header *)paging_map_mmio(phys, sizeof(t_acpi_header));
+    if (header == NULL)
+    {
+        return (NULL);
+    }
+    length = header->length;
+    if (length < sizeof(t_acpi_header) || length > 0x100000 ||
+        paging_map_mmio(phys, length) == NULL ||
+        !acpi_checksum_ok(header, length))
+    {
+        return (NULL);
+    }
+    return (header);
+}
+
+static void __init acpi_add_table(uint32_t phys)
+{
+    if (g_acpi.table_count >= ACPI_MAX_TABLES || acpi_map_table(phys) == NULL)
+    {
+        return;
+    }
+    g_acpi.tables[g_acpi.table_count] = phys;
+    g_acpi.table_count++;
+}
+
+static void __init acpi_parse_madt(const t_acpi_madt *madt)
+{
+    const t_madt_entry  *entry;
+    uint32_t            offset;
+
+    g_acpi.has_madt = TRUE;
+    g_acpi.lapic_address = madt->lapic_address;
+    g_acpi.pcat_compat = (bool_t)((madt->flags & MADT_PCAT_COMPAT) != 0);
+    offset = sizeof(t_acpi_madt);
+    while (offset + sizeof(t_madt_entry) <= madt->header.length)
+    {
+        entry = (const t_madt_entry *)((uint32_t)madt + offset);
+        if (entry->length < sizeof(t_madt_entry) ||
+            offset + entry->length > madt->header.length)
+        {
+            break;
+        }
+        if (entry->type == MADT_LAPIC && g_acpi.cpu_count < ACPI_MAX_CPUS)
+        {
+            const t_madt_lapic *lapic = (const t_madt_lapic *)entry;
+
+            if ((lapic->flags & (MADT_LAPIC_ENABLED | MADT_LAPIC_ONLINE_CAP)) != 0)
+            {
+                g_acpi.cpus[g_acpi.cpu_count].acpi_id = lapic->acpi_id;
+                g_acpi.cpus[g_acpi.cpu_count].apic_id = lapic->apic_id;
+                g_acpi.cpus[g_acpi.cpu_count].enabled =
+                    (bool_t)((lapic->flags & MADT_LAPIC_ENABLED) != 0);
+                g_acpi.cpu_count++;
+            }
+        }
+        else if (entry->type == MADT_IOAPIC &&
+                 g_acpi.ioapic_count < ACPI_MAX_IOAPICS)
+        {
+            const t_madt_ioapic *ioapic = (const t_madt_ioapic *)entry;
+
+            g_acpi.ioapics[g_acpi.ioapic_count].id = ioapic->id;
+            g_acpi.ioapics[g_acpi.ioapic_count].address = ioapic->address;
+            g_acpi.ioapics[g_acpi.ioapic_count].gsi_base = ioapic->gsi_base;
+            g_acpi.ioapic_count++;
+        }
+        else if (entry->type == MADT_ISO &&
+                 g_acpi.override_count < ACPI_MAX_OVERRIDES)
+        {
+            const t_madt_iso *iso = (const t_madt_iso *)entry;
+
+            g_acpi.overrides[g_acpi.override_count].source = iso->source;
+            g_acpi.overrides[g_acpi.override_count].gsi = iso->gsi;
+            g_acpi.overrides[g_acpi.override_count].flags = iso->flags;
+            g_acpi.override_count++;
+        }
+        else if (entry->type == MADT_LAPIC_OVERRIDE)
+        {
+            const t_madt_lapic_override *over;
+
+            over = (const t_madt_lapic_override *)entry;
+            if (over->address < 0x100000000ULL)
+            {
+                g_acpi.lapic_address = (uint32_t)over->address;
+            }
+        }
+        offset += entry->length;
+    }
+}
+
+static void __init acpi_parse_hpet(const t_acpi_hpet *hpet)
+{
+    if (hpet->header.length < sizeof(t_acpi_hpet) ||
+        hpet->address.space_id != 0 ||
+        hpet->address.address >= 0x100000000ULL)
+    {
+        return;
+    }
+    g_acpi.has_hpet = TRUE;
+    g_acpi.hpet_address = (uint32_t)hpet->address.address;
+    g_acpi.hpet_number = hpet->hpet_number;
+    g_acpi.hpet_min_tick = hpet->min_tick;
+}
+
+static void __init acpi_apply(void)
+{
+    uint32_t    i;
+
+    for (i = 0; i < g_acpi.ioapic_count; i++)
+    {
+        ioapic_add(g_acpi.ioapics[i].id, g_acpi.ioapics[i].address,
+                   g_acpi.ioapics[i].gsi_base);
+    }
+    for (i = 0; i < g_acpi.override_count; i++)
+    {
+        ioapic_set_isa_override(g_acpi.overrides[i].source,
+                                g_acpi.overrides[i].gsi,
+                                g_acpi.overrides[i].flags);
+    }
+}
+
+void __init acpi_init(void)
+{
+    const t_acpi_rsdp   *rsdp;
+    const t_acpi_header *root;
+    const t_acpi_header *table;
+    uint64_t            entry64;
+    uint32_t            entry_size;
+    uint32_t            count;
+    uint32_t            i;
+
+    rsdp = acpi_find_rsdp();
+    if (rsdp == NULL)
+    {
+        return;
+    }
+    g_acpi.revision = rsdp->revision;
+    k_memcpy(g_acpi.oem_id, rsdp->oem_id, 6);
+    g_acpi.oem_id[6] = '\0';
+    root = NULL;
+    entry_size = 4;
+    if (rsdp->revision >= 2 && rsdp->xsdt_address != 0 &&
+        rsdp->xsdt_address < 0x100000000ULL)
+    {
+        root = acpi_map_table((uint32_t)rsdp->xsdt_address);
+        entry_size = 8;
+    }
+    if (root == NULL)
+    {
+        root = acpi_map_table(rsdp->rsdt_address);
+        entry_size = 4;
+    }
+    if (root == NULL)
+    {
+        return;
+    }
+    g_acpi.present = TRUE;
+    count = (root->length - (uint32_t)sizeof(t_acpi_header)) / entry_size;
+    for (i = 0; i < count; i++)
+    {
+        entry64 = 0;
+        k_memcpy(&entry64, (const uint8_t *)(root + 1) + i * entry_size,
+                 entry_size);
+        if (entry64 != 0 && entry64 < 0x100000000ULL)
+        {
+            acpi_add_table((uint32_t)entry64);
+        }
+    }
+
+
+    table = acpi_find_table("APIC");
+    if (table != NULL && table->length >= sizeof(t_acpi_madt))
+    {
+        acpi_parse_madt((const t_acpi_madt *)table);
+    }
+    table = acpi_find_table("HPET");
+    if (table != NULL)
+    {
+        acpi_parse_hpet((const t_acpi_hpet *)table);
+    }
+    acpi_apply();
+}
+
+const t_acpi_info *acpi_get_info(void)
+{
+    return (&g_acpi);
+}
+
+const t_acpi_header *acpi_find_table(const char *signature)
+{
+    const t_acpi_header *header;
+    uint32_t            i;
+
+    for (i = 0; i < g_acpi.table_count; i++)
+    {
+        header = (const t_acpi_header *)g_acpi.tables[i];
+        if (k_memcmp(header->signature, signature, 4) == 0)
+        {
+            return (header);
+        }
+    }
+    return (NULL);
+}
+
+static void acpi_print_sig(const char *text, uint32_t length)
+{
+    uint32_t    i;
+
+    for (i = 0; i < length; i++)
+    {
+        printk("%c", text[i] != '\0' ? text[i] : ' ');
+    }
+}
+
+void acpi_print(void)
+{
+    const t_acpi_header *header;
+    uint32_t            i;
+
+    printk("\n=== ACPI ===\n");
+    if (!g_acpi.present)
+    {
+        printk("  No valid RSDP found\n\n");
+        return;
+    }
+    printk("  RSDP revision %u, OEM '%s', %u tables\n",
+           (uint32_t)g_acpi.revision, g_acpi.oem_id, g_acpi.table_count);
+    for (i = 0; i < g_acpi.table_count; i++)
+    {
+        header = (const t_acpi_header *)g_acpi.tables[i];
+        printk("  ");
+        acpi_print_sig(header->signature, 4);
+        printk(" @ 0x%x  len %u  rev %u  ", g_acpi.tables[i], header->length,
+               (uint32_t)header->revision);
+        acpi_print_sig(header->oem_table_id, 8);
+        printk("\n");
+    }
+    if (g_acpi.has_madt)
+    {
+        printk("  MADT: LAPIC @ 0x%x%s\n", g_acpi.lapic_address,
+               g_acpi.pcat_compat ? ", dual 8259 present" : "");
+        for (i = 0; i < g_acpi.cpu_count; i++)
+        {
+            printk("    CPU %u: APIC ID %u%s\n", (uint32_t)g_acpi.cpus[i].acpi_id,
+                   (uint32_t)g_acpi.cpus[i].apic_id,
+                   g_acpi.cpus[i].enabled ? "" : " (disabled)");
+        }
+        for (i = 0; i < g_acpi.ioapic_count; i++)
+        {
+            printk("    IOAPIC %u @ 0x%x, GSI base %u\n",
+                   (uint32_t)g_acpi.ioapics[i].id, g_acpi.ioapics[i].address,
+                   g_acpi.ioapics[i].gsi_base);
+        }
+        for (i = 0; i < g_acpi.override_count; i++)
+        {
+            printk("    Override: IRQ %u -> GSI %u, flags 0x%x\n",
+                   (uint32_t)g_acpi.overrides[i].source,
+                   g_acpi.overrides[i].gsi,
+                   (uint32_t)g_acpi.overrides[i].flags);
+        }
+    }
+    if (g_acpi.has_hpet)
+    {
+        printk("  HPET %u @ 0x%x, min tick %u\n", (uint32_t)g_acpi.hpet_number,
+               g_acpi.hpet_address, (uint32_t)g_acpi.hpet_min_tick);
+    }
+    printk("\n");
+}
@@ -0,0 +1,401 @@
+#include "kernel.h"
+#include "../include/apic.h"
+#include "../include/irqchip.h"
+#include "../include/idt.h"
+#include "../include/cpu.h"
+#include "../include/pmm.h"
+#include "../include/paging.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
+
+static volatile uint32_t    *g_lapic;
+static bool_t               g_apic_enabled;
+static uint32_t             g_apic_spurious;
+static uint32_t             g_lapic_timer_khz;
+
+static t_ioapic             g_ioapics[IOAPIC_MAX];
+static uint32_t             g_ioapic_count;
+
+static t_isa_override       g_isa_overrides[ISA_IRQS];
+static uint16_t             g_isa_override_set;
+
+uint32_t lapic_read(uint32_t reg)
+{
+    return (g_lapic[reg / 4]);
+}
+
+void lapic_write(uint32_t reg, uint32_t value)
+{
+    g_lapic[reg / 4] = value;
+}
+
+uint8_t lapic_id(void)
+{
+    return ((uint8_t)(lapic_read(LAPIC_ID) >> 24));
+}
+
+void lapic_eoi(void)
+{
+    lapic_write(LAPIC_EOI, 0);
+}
+
+static void lapic_wait_icr(void)
+{
+    while ((lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING) != 0)
+    {
+        cpu_relax();
+    }
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint32_t icr_low)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    lapic_wait_icr();
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << LAPIC_ICR_DEST_SHIFT);
+    lapic_write(LAPIC_ICR_LOW, icr_low);
+    lapic_wait_icr();
+    irq_restore(flags);
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL |
+                   LAPIC_ICR_ASSERT);
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL);
+}
+
+void lapic_send_sipi(uint8_t apic_id, uint8_t page)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | page);
+}
+
+void lapic_send_vector(uint8_t apic_id, uint8_t vector)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_FIXED | vector);
+}
+
+void lapic_send_vector_others(uint8_t vector)
+{
+    lapic_send_ipi(0, LAPIC_ICR_OTHERS | LAPIC_ICR_FIXED | vector);
+}
+
+void lapic_send_nmi_others(void)
+{
+    lapic_send_ipi(0, LAPIC_ICR_OTHERS | LAPIC_ICR_NMI);
+}
+
+static void lapic_timer_start(uint32_t initial_count, bool_t periodic)
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, APIC_TIMER_VECTOR |
+                (periodic ? LAPIC_LVT_PERIODIC : 0));
+    lapic_write(LAPIC_TIMER_INITIAL, initial_count);
+}
+
+static void lapic_timer_stop(void)
+{
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | APIC_TIMER_VECTOR);
+}
+
+static int lapic_timer_handler(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+
+    tick_handle();
+    return (IRQ_HANDLED);
+}
+
+static void lapic_timer_set_periodic(uint32_t hz)
+{
+    lapic_timer_start((uint32_t)k_udivmod64((uint64_t)g_lapic_timer_khz * 1000,
+                                            hz, NULL), TRUE);
+}
+
+static void lapic_timer_set_oneshot(uint64_t delta_ns)
+{
+    uint64_t    count;
+
+    count = k_udivmod64(delta_ns * g_lapic_timer_khz, NSEC_PER_MSEC, NULL);
+    if (count == 0)
+    {
+        count = 1;
+    }
+    if (count > 0xFFFFFFFFULL)
+    {
+        count = 0xFFFFFFFFULL;
+    }
+    lapic_timer_start((uint32_t)count, FALSE);
+}
+
+const t_clockevent  g_lapic_clockevent = {
+    "LAPIC",
+    LAPIC_ONESHOT_MIN_NS,
+    LAPIC_ONESHOT_MAX_NS,
+    lapic_timer_set_periodic,
+    lapic_timer_set_oneshot
+};
+
+int __init lapic_timer_init(void)
+{
+    uint64_t    start;
+    uint64_t    elapsed;
+    uint32_t    remaining;
+    uint32_t    flags;
+
+    if (!g_apic_enabled || tsc_get_info()->mult == 0)
+    {
+        return (-1);
+    }
+    flags = irq_save();
+    lapic_timer_start(0xFFFFFFFFU, FALSE);
+    start = ktime_ns();
+    do
+    {
+        elapsed = ktime_ns() - start;
+        remaining = lapic_read(LAPIC_TIMER_CURRENT);
+    } while (elapsed < LAPIC_CALIBRATE_NS);
+    lapic_timer_stop();
+    irq_restore(flags);
+    g_lapic_timer_khz = (uint32_t)k_udivmod64(
+        (uint64_t)(0xFFFFFFFFU - remaining) * NSEC_PER_MSEC,
+        (uint32_t)elapsed, NULL);
+    if (g_lapic_timer_khz == 0)
+    {
+        return (-1);
+    }
+    int_register(APIC_TIMER_VECTOR, lapic_timer_handler, NULL);
+    return (0);
+}
+
+uint32_t lapic_timer_khz(void)
+{
+    return (g_lapic_timer_khz);
+}
+
+static uint32_t ioapic_read(const t_ioapic *ioapic, uint32_t reg)
+{
+    ioapic->regs[IOAPIC_REGSEL / 4] = reg;
+    return (ioapic->regs[IOAPIC_WIN / 4]);
+}
+
+static void ioapic_write(const t_ioapic *ioapic, uint32_t reg, uint32_t value)
+{
+    ioapic->regs[IOAPIC_REGSEL / 4] = reg;
+    ioapic->regs[IOAPIC_WIN / 4] = value;
+}
+
+static const t_ioapic *ioapic_for_gsi(uint32_t gsi)
+{
+    uint32_t    i;
+
+    for (i = 0; i < g_ioapic_count; i++)
+    {
+        if (gsi >= g_ioapics[i].gsi_base &&
+            gsi < g_ioapics[i].gsi_base + g_ioapics[i].entries)
+        {
+            return (&g_ioapics[i]);
+        }
+    }
+    return (NULL);
+}
+
+int __init ioapic_add(uint8_t id, uint32_t phys, uint32_t gsi_base)
+{
+    t_ioapic    *ioapic;
+    uint32_t    version;
+    uint32_t    i;
+
+    if (g_ioapic_count >= IOAPIC_MAX)
+    {
+        return (-1);
+    }
+    ioapic = &g_ioapics[g_ioapic_count];
+    ioapic->regs = (volatile uint32_t *)paging_map_mmio(phys, PAGE_SIZE);
+    if (ioapic->regs == NULL)
+    {
+        return (-1);
+    }
+    version = ioapic_read(ioapic, IOAPIC_REG_VER);
+    if (version == 0xFFFFFFFFU || (version & 0xFF) == 0)
+    {
+        return (-1);
+    }
+    ioapic->id = id;
+    ioapic->gsi_base = gsi_base;
+    ioapic->entries = (uint8_t)(((version >> 16) & 0xFF) + 1);
+    for (i = 0; i < ioapic->entries; i++)
+    {
+        ioapic_write(ioapic, IOAPIC_REG_REDTBL + i * 2, IOAPIC_MASKED);
+        ioapic_write(ioapic, IOAPIC_REG_REDTBL + i * 2 + 1, 0);
+    }
+    g_ioapic_count++;
+    return (0);
+}
+
+void __init ioapic_set_isa_override(uint8_t isa_irq, uint32_t gsi, uint16_t flags)
+{
+    if (isa_irq >= ISA_IRQS)
+    {
+        return;
+    }
+    g_isa_overrides[isa_irq].gsi = gsi;
+    g_isa_overrides[isa_irq].flags = flags;
+    g_isa_override_set = (uint16_t)(g_isa_override_set | (1U << isa_irq));
+}
+
+uint32_t ioapic_isa_to_gsi(uint8_t isa_irq)
+{
+    if ((g_isa_override_set & (1U << isa_irq)) != 0)
+    {
+        return (g_isa_overrides[isa_irq].gsi);
+    }
+    return (isa_irq);
+}
+
+static void ioapic_route(uint8_t irq, bool_t masked)
+{
+    const t_ioapic  *ioapic;
+    uint32_t        gsi;
+    uint32_t        low;
+    uint32_t        pin;
+    uint16_t        flags;
+
+    gsi = ioapic_isa_to_gsi(irq);
+    ioapic = ioapic_for_gsi(gsi);
+    if (ioapic == NULL)
+    {
+        return;
+    }
+    flags = 0;
+    if ((g_isa_override_set & (1U << irq)) != 0)
+    {
+        flags = g_isa_overrides[irq].flags;
+    }
+    low = IRQ_BASE + irq;
+    if ((flags & MPS_POLARITY_MASK) == MPS_POLARITY_LOW)
+    {
+        low |= IOAPIC_ACTIVE_LOW;
+    }
+    if ((flags & MPS_TRIGGER_MASK) == MPS_TRIGGER_LEVEL)
+    {
+        low |= IOAPIC_LEVEL;
+    }
+    if (masked)
+    {
+        low |= IOAPIC_MASKED;
+    }
+    pin = gsi - ioapic->gsi_base;
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL + pin * 2 + 1,
+                 (uint32_t)lapic_id() << 24);
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL + pin * 2, low);
+}
+
+static void apic_chip_mask(uint8_t irq)
+{
+    ioapic_route(irq, TRUE);
+}
+
+static void apic_chip_unmask(uint8_t irq)
+{
+    ioapic_route(irq, FALSE);
+}
+
+static void apic_chip_eoi(uint32_t vector)
+{
+    if (vector != APIC_SPURIOUS_VECTOR)
+    {
+        lapic_eoi();
+    }
+}
+
+static bool_t apic_chip_is_spurious(uint32_t vector)
+{
+    if (vector == APIC_SPURIOUS_VECTOR)
+    {
+        g_apic_spurious++;
+        return (TRUE);
+    }
+    return (FALSE);
+}
+
+const t_irqchip g_apic_chip = {
+    "APIC",
+    apic_chip_mask,
+    apic_chip_unmask,
+    apic_chip_eoi,
+    apic_chip_is_spurious
+};
+
+bool_t apic_supported(void)
+{
+    t_cpuid_regs    regs;
+
+    regs = cpuid(1, 0);
+    return ((bool_t)((regs.edx & CPUID_FEAT_EDX_APIC) != 0 &&
+                     (regs.edx & CPUID_FEAT_EDX_MSR) != 0));
+}
+
+bool_t apic_enabled(void)
+{
+    return (g_apic_enabled);
+}
+
+int __init apic_init(void)
+{
+    uint64_t    base;
+
+    if (!apic_supported())
+    {
+        return (-1);
+    }
+    base = rdmsr(MSR_APIC_BASE);
+    g_lapic = (volatile uint32_t *)paging_map_mmio(
+        (phys_addr_t)(base & APIC_BASE_ADDR_MASK), PAGE_SIZE);
+    if (g_lapic == NULL)
+    {
+        return (-1);
+    }
+    if (g_ioapic_count == 0 && ioapic_add(0, IOAPIC_DEFAULT_BASE, 0) != 0)
+    {
+        return (-1);
+    }
+    lapic_setup();
+    g_apic_enabled = TRUE;
+    return (0);
+}
+
+void lapic_setup(void)
+{
+    uint64_t    base;
+
+    base = rdmsr(MSR_APIC_BASE);
+    if ((base & APIC_BASE_ENABLE) == 0)
+    {
+        wrmsr(MSR_APIC_BASE, base | APIC_BASE_ENABLE);
+    }
+    lapic_write(LAPIC_DFR, 0xFFFFFFFFU);
+    lapic_write(LAPIC_LDR, (lapic_read(LAPIC_LDR) & 0x00FFFFFFU) | (1U << 24));
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | APIC_TIMER_VECTOR);
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, LAPIC_LVT_NMI);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | APIC_SPURIOUS_VECTOR);
+    lapic_eoi();
+}
+
+uint32_t apic_spurious_count(void)
+{
+    return (g_apic_spurious);
+}
+
+void apic_reset_spurious(void)
+{
+    g_apic_spurious = 0;
+}
@@ -0,0 +1,60 @@
+#include "kernel.h"
+#include "../include/cmdline.h"
+
+static char g_cmdline[CMDLINE_MAX];
+
+void __init cmdline_init(const t_multiboot_info *mbi)
+{
+    if ((mbi->flags & MULTIBOOT_INFO_CMDLINE) == 0 || mbi->cmdline == 0)
+    {
+        g_cmdline[0] = '\0';
+        return;
+    }
+    k_strncpy(g_cmdline, (const char *)mbi->cmdline, CMDLINE_MAX - 1);
+    g_cmdline[CMDLINE_MAX - 1] = '\0';
+}
+
+static const char *cmdline_find(const char *key, size_t key_len)
+{
+    const char  *p;
+
+    p = g_cmdline;
+    while (*p != '\0')
+    {
+        while (*p == ' ')
+        {
+            p++;
+        }
+        if (k_strncmp(p, key, key_len) == 0 &&
+            (p[key_len] == '\0' || p[key_len] == ' ' || p[key_len] == '='))
+        {
+            return (p + key_len);
+        }
+        while (*p != '\0' && *p != ' ')
+        {
+            p++;
+        }
+    }
+    return (NULL);
+}
+
+bool_t cmdline_get(const char *key, char *value, size_t size)
+{
+    const char  *p;
+    size_t      i;
+
+    p = cmdline_find(key, k_strlen(key));
+    if (p == NULL || *p != '=' || size == 0)
+    {
+        return (FALSE);
+    }
+    p++;
+    i = 0;
+    while (p[i] != '\0' && p[i] != ' ' && i + 1 < size)
+    {
+        value[i] = p[i];
+        i++;
+    }
+    value[i] = '\0';
+    return (TRUE);
+}
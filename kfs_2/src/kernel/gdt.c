@@ -1,5 +1,6 @@
 #include "gdt.h"
 #include "types.h"
+#include "../lib/string.h"
 
 extern void printk(const char *fmt, ...);
 
@@ -33,8 +34,9 @@ void    gdt_set_entry(uint32_t index, uint32_t base, uint32_t limit,
     entry->access = access;
 }
 
-void    gdt_init(void)
+void    __init gdt_init(void)
 {
+    uint32_t    i;
 
     g_gdt_ptr.limit = (uint16_t)((sizeof(t_gdt_entry) * GDT_ENTRIES) - 1);
     g_gdt_ptr.base = GDT_ADDRESS;
@@ -67,12 +69,55 @@ void    gdt_init(void)
                   GDT_USER_DATA_ACCESS, GDT_FLAGS_32BIT);
 
 
+    for (i = GDT_TSS_BASE; i < GDT_ENTRIES; i++)
+    {
+        gdt_set_entry(i, 0, 0, 0, 0);
+    }
+
+
+    gdt_flush((uint32_t)&g_gdt_ptr);
+}
+
+void    gdt_reload(void)
+{
     gdt_flush((uint32_t)&g_gdt_ptr);
 }
 
+void    gdt_load_tss(uint32_t cpu, t_tss *tss, uint32_t esp0)
+{
+    uint16_t    selector;
+
+    if (cpu >= GDT_MAX_CPUS)
+    {
+        return;
+    }
+    k_memset(tss, 0, sizeof(*tss));
+    tss->ss0 = GDT_KERNEL_DATA;
+    tss->esp0 = esp0;
+    tss->iomap_base = (uint16_t)sizeof(*tss);
+    gdt_set_entry(GDT_TSS_BASE + cpu, (uint32_t)tss, sizeof(*tss) - 1,
+                  GDT_TSS_ACCESS, 0);
+    selector = (uint16_t)GDT_TSS_SELECTOR(cpu);
+    __asm__ volatile ("ltr %0" : : "r"(selector));
+}
+
+void    gdt_load_percpu(uint32_t cpu, uint32_t base, uint32_t size)
+{
+    uint16_t    selector;
+
+    if (cpu >= GDT_MAX_CPUS || size == 0)
+    {
+        return;
+    }
+    gdt_set_entry(GDT_PERCPU_BASE + cpu, base, size - 1,
+                  GDT_KERNEL_DATA_ACCESS, GDT_FLAG_32BIT);
+    selector = (uint16_t)GDT_PERCPU_SELECTOR(cpu);
+    __asm__ volatile ("mov %0, %%gs" : : "r"(selector) : "memory");
+}
+
 void    gdt_print(void)
 {
-    static const char *names[GDT_ENTRIES] = {
+    static const char *names[GDT_BASE_ENTRIES] = {
         "Null",
         "Kernel Code",
         "Kernel Data",
@@ -93,6 +138,10 @@ void    gdt_print(void)
     for (i = 0; i < GDT_ENTRIES; i++)
     {
         entry = &g_gdt[i];
+        if (i >= GDT_TSS_BASE && (entry->access & GDT_ACCESS_PRESENT) == 0)
+        {
+            continue;
+        }
 
 
         base = (uint32_t)entry->base_low |
@@ -103,7 +152,24 @@ void    gdt_print(void)
         limit = (uint32_t)entry->limit_low |
                 (((uint32_t)entry->flags_limit & 0x0F) << 16);
 
-        printk("Entry %d [0x%x]: %s\n", i, i * 8, names[i]);
+        if (i < GDT_TSS_BASE)
+        {
+            printk("Entry %d [0x%x]: %s\n", i, i * 8, names[i]);
+        }
+        else if (i == GDT_DF_TSS)
+        {
+            printk("Entry %d [0x%x]: TSS (double fault)\n", i, i * 8);
+        }
+        else if (i < GDT_PERCPU_BASE)
+        {
+            printk("Entry %d [0x%x]: TSS (cpu %d)\n", i, i * 8,
+                   i - GDT_TSS_BASE);
+        }
+        else
+        {
+            printk("Entry %d [0x%x]: Per-CPU GS (cpu %d)\n", i, i * 8,
+                   i - GDT_PERCPU_BASE);
+        }
         printk("  Base:   0x%x\n", base);
         printk("  Limit:  0x%x", limit);
 
@@ -125,7 +191,12 @@ void    gdt_print(void)
         {
             printk(" [Present");
             printk(" Ring%d", (entry->access >> 5) & 0x03);
-            if (entry->access & GDT_ACCESS_EXECUTABLE)
+            if ((entry->access & GDT_ACCESS_DESCRIPTOR) == 0)
+            {
+                printk(" TSS%s",
+                       (entry->access & GDT_ACCESS_RW) ? " Busy" : "");
+            }
+            else if (entry->access & GDT_ACCESS_EXECUTABLE)
             {
                 printk(" Code");
             }
@@ -133,7 +204,8 @@ void    gdt_print(void)
             {
                 printk(" Data");
             }
-            if (entry->access & GDT_ACCESS_RW)
+            if ((entry->access & GDT_ACCESS_DESCRIPTOR) != 0 &&
+                (entry->access & GDT_ACCESS_RW))
             {
                 printk(" R/W");
             }
@@ -0,0 +1,213 @@
+#include "kernel.h"
+#include "../include/irqstat.h"
+#include "../include/idt.h"
+#include "../include/cpu.h"
+#include "../include/softirq.h"
+#include "../include/pic.h"
+#include "../include/apic.h"
+#include "../include/irqchip.h"
+#include "../include/percpu.h"
+#include "../include/smp.h"
+#include "../include/atomic.h"
+#include "../lib/string.h"
+#include "../lib/math.h"
+
+static t_irqstat    g_irqstat[SMP_MAX_CPUS][IRQSTAT_VECTORS];
+
+void irqstat_record(uint32_t vector, uint64_t start, uint64_t end)
+{
+    t_irqstat   *stat;
+    uint64_t    delta;
+    uint32_t    cycles;
+    uint32_t    bucket;
+
+    stat = &g_irqstat[this_cpu_read(cpu)][vector & (IRQSTAT_VECTORS - 1)];
+    delta = end - start;
+    cycles = (delta > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)delta;
+    stat->seq++;
+    barrier();
+    if (stat->count == 0 || cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+    stat->count++;
+    stat->total += cycles;
+    bucket = (cycles == 0) ? 0 : (uint32_t)(31 - __builtin_clz(cycles));
+    if (bucket >= IRQSTAT_BUCKETS)
+    {
+        bucket = IRQSTAT_BUCKETS - 1;
+    }
+    stat->hist[bucket]++;
+    barrier();
+    stat->seq++;
+}
+
+static void irqstat_reset_cpu(void *arg)
+{
+    (void)arg;
+    k_memset(g_irqstat[this_cpu_read(cpu)], 0, sizeof(g_irqstat[0]));
+}
+
+void irqstat_reset(void)
+{
+    uint32_t    flags;
+
+    smp_call_function(SMP_ALL_CPUS, irqstat_reset_cpu, NULL, TRUE);
+    flags = irq_save();
+    pic_reset_spurious();
+    apic_reset_spurious();
+    irq_restore(flags);
+}
+
+static void irqstat_read(const t_irqstat *stat, t_irqstat *out)
+{
+    uint32_t    seq;
+
+    do
+    {
+        seq = stat->seq;
+        barrier();
+        *out = *stat;
+        barrier();
+    }
+    while ((seq & 1) != 0 || seq != stat->seq);
+}
+
+void irqstat_get(uint8_t vector, t_irqstat *out)
+{
+    t_irqstat   stat;
+    uint32_t    cpu;
+    uint32_t    i;
+
+    k_memset(out, 0, sizeof(*out));
+    for (cpu = 0; cpu < SMP_MAX_CPUS; cpu++)
+    {
+        irqstat_read(&g_irqstat[cpu][vector], &stat);
+        if (stat.count == 0)
+        {
+            continue;
+        }
+        if (out->count == 0 || stat.min < out->min)
+        {
+            out->min = stat.min;
+        }
+        if (stat.max > out->max)
+        {
+            out->max = stat.max;
+        }
+        out->count += stat.count;
+        out->total += stat.total;
+        for (i = 0; i < IRQSTAT_BUCKETS; i++)
+        {
+            out->hist[i] += stat.hist[i];
+        }
+    }
+}
+
+static uint32_t irqstat_average(const t_irqstat *stat)
+{
+    if (stat->count == 0)
+    {
+        return (0);
+    }
+    return ((uint32_t)k_udivmod64(stat->total, stat->count, NULL));
+}
+
+static void irqstat_print_source(uint8_t vector)
+{
+    if (vector < EXCEPTION_COUNT)
+    {
+        printk("exc %u", (uint32_t)vector);
+    }
+    else if (vector < IRQ_BASE + IRQ_LINES)
+    {
+        printk("IRQ %u", (uint32_t)(vector - IRQ_BASE));
+    }
+    else
+    {
+        printk("vec %u", (uint32_t)vector);
+    }
+}
+
+void irqstat_print(void)
+{
+    t_irqstat   stat;
+    uint32_t    i;
+    uint32_t    used;
+
+    printk("\n=== Interrupt Statistics (cycles) ===\n");
+    used = 0;
+    for (i = 0; i < IRQSTAT_VECTORS; i++)
+    {
+        irqstat_get((uint8_t)i, &stat);
+        if (stat.count == 0)
+        {
+            continue;
+        }
+        printk("  ");
+        irqstat_print_source((uint8_t)i);
+        printk(": count %u  min %u  avg %u  max %u\n", stat.count, stat.min,
+               irqstat_average(&stat), stat.max);
+        used++;
+    }
+    if (used == 0)
+    {
+        printk("  No interrupts recorded\n");
+    }
+    printk("  %s  spurious: IRQ 7 %u  IRQ 15 %u  APIC %u\n",
+           g_irqchip->name, pic_spurious_count(7), pic_spurious_count(15),
+           apic_spurious_count());
+    softirq_print();
+    printk("\n");
+}
+
+void irqstat_print_vector(uint8_t vector)
+{
+    t_irqstat   stat;
+    uint32_t    peak;
+    uint32_t    bar;
+    uint32_t    i;
+    uint32_t    j;
+
+    irqstat_get(vector, &stat);
+    printk("\n=== ");
+    irqstat_print_source(vector);
+    printk(" (vector %u) ===\n", (uint32_t)vector);
+    printk("  count %u  min %u  avg %u  max %u  total %llu\n", stat.count,
+           stat.min, irqstat_average(&stat), stat.max, stat.total);
+    peak = 0;
+    for (i = 0; i < IRQSTAT_BUCKETS; i++)
+    {
+        if (stat.hist[i] > peak)
+        {
+            peak = stat.hist[i];
+        }
+    }
+    for (i = 0; i < IRQSTAT_BUCKETS && peak != 0; i++)
+    {
+        if (stat.hist[i] == 0)
+        {
+            continue;
+        }
+        if (i == IRQSTAT_BUCKETS - 1)
+        {
+            printk("  >= %u: %u ", 1U << i, stat.hist[i]);
+        }
+        else
+        {
+            printk("  < %u: %u ", 2U << i, stat.hist[i]);
+        }
+        bar = (uint32_t)k_udivmod64((uint64_t)stat.hist[i] * IRQSTAT_BAR_WIDTH
+                                    + peak - 1, peak, NULL);
+        for (j = 0; j < bar; j++)
+        {
+            printk("#");
+        }
+        printk("\n");
+    }
+    printk("\n");
+}
@@ -1,65 +1,361 @@
 #include "kernel.h"
 #include "../include/idt.h"
+#include "../include/gdt.h"
 #include "../include/pic.h"
-#include "../include/keyboard.h"
-#include "../include/mouse.h"
-#include "../include/vtty.h"
+#include "../include/apic.h"
+#include "../include/irqchip.h"
+#include "../include/cpu.h"
+#include "../include/stack.h"
+#include "../include/pmm.h"
+#include "../include/percpu.h"
+#include "../include/spinlock.h"
+#include "../include/smp.h"
+#include "../lib/math.h"
 
-void isr_handler(void)
-{
+const t_irqchip     *g_irqchip = &g_pic_chip;
+
+static t_int_action g_action_pool[INT_ACTION_POOL];
+static t_int_action *volatile g_int_table[IDT_ENTRIES];
+static t_rwlock     g_int_lock = RWLOCK_INIT("int_table");
+static t_tss        g_df_tss;
+
+static const char *const g_exception_names[EXCEPTION_COUNT] = {
+    "Divide error",             "Debug",
+    "NMI",                      "Breakpoint",
+    "Overflow",                 "BOUND range exceeded",
+    "Invalid opcode",           "Device not available",
+    "Double fault",             "Coprocessor segment overrun",
+    "Invalid TSS",              "Segment not present",
+    "Stack-segment fault",      "General protection fault",
+    "Page fault",               "Reserved",
+    "x87 FPU error",            "Alignment check",
+    "Machine check",            "SIMD floating-point",
+    "Virtualization",           "Control protection",
+    "Reserved",                 "Reserved",
+    "Reserved",                 "Reserved",
+    "Reserved",                 "Reserved",
+    "Hypervisor injection",     "VMM communication",
+    "Security exception",       "Reserved"
+};
 
+void __init irq_stack_init(void)
+{
+    uint32_t    base;
 
-    __asm__ volatile ("cli; hlt");
-    while (1) { __asm__ volatile ("hlt"); }
+    base = stack_alloc("irq", IRQ_STACK_SIZE);
+    KERNEL_ASSERT(base != 0, "Cannot allocate the IRQ stack");
+    this_cpu_write(irq_stack_top, base + IRQ_STACK_SIZE);
 }
 
-static void handle_keyboard_irq(void)
+void __init irqchip_init(void)
 {
+    uint16_t    enabled;
+    uint8_t     irq;
 
-    keyboard_handler();
+    if (apic_init() != 0)
+    {
+        g_irqchip = &g_pic_chip;
+        return;
+    }
+    enabled = (uint16_t)~pic_get_mask();
+    pic_update_mask(0xFFFF, 0);
+    g_irqchip = &g_apic_chip;
+    for (irq = 0; irq < IRQ_LINES; irq++)
+    {
+        if (irq != PIC_CASCADE_IRQ && (enabled & (1U << irq)) != 0)
+        {
+            g_irqchip->unmask(irq);
+        }
+    }
 }
 
-static void handle_mouse_irq(void)
+int int_register(uint8_t vector, t_int_handler handler, void *ctx)
 {
-    t_mouse_event event;
+    t_int_action            *action;
+    t_int_action *volatile  *link;
+    uint32_t                flags;
+    uint32_t                i;
 
-    mouse_handler();
+    if (handler == NULL)
+    {
+        return (-1);
+    }
+    flags = write_lock_irqsave(&g_int_lock);
+    action = NULL;
+    for (i = 0; i < INT_ACTION_POOL; i++)
+    {
+        if (g_action_pool[i].handler == NULL)
+        {
+            action = &g_action_pool[i];
+            break;
+        }
+    }
+    if (action == NULL)
+    {
+        write_unlock_irqrestore(&g_int_lock, flags);
+        return (-1);
+    }
+    action->handler = handler;
+    action->ctx = ctx;
+    action->next = NULL;
 
-    while (mouse_has_event())
+    link = &g_int_table[vector];
+    while (*link != NULL)
     {
-        event = mouse_get_event();
+        link = &(*link)->next;
+    }
+    barrier();
+    *link = action;
+    write_unlock_irqrestore(&g_int_lock, flags);
+    return (0);
+}
+
+static void int_sync(void *arg)
+{
+    (void)arg;
+}
 
+int int_unregister(uint8_t vector, t_int_handler handler, void *ctx)
+{
+    t_int_action *volatile  *link;
+    t_int_action            *action;
+    uint32_t                flags;
 
-        if (event.delta_z > 0)
+    flags = write_lock_irqsave(&g_int_lock);
+    link = &g_int_table[vector];
+    while (*link != NULL)
+    {
+        action = *link;
+        if (action->handler == handler && action->ctx == ctx)
         {
-
-            vtty_scroll_up(3);
+            *link = action->next;
+            write_unlock_irqrestore(&g_int_lock, flags);
+            smp_call_function(SMP_ALL_CPUS & ~SMP_CPU(smp_processor_id()),
+                              int_sync, NULL, TRUE);
+            flags = write_lock_irqsave(&g_int_lock);
+            action->handler = NULL;
+            write_unlock_irqrestore(&g_int_lock, flags);
+            return (0);
         }
-        else if (event.delta_z < 0)
-        {
+        link = &action->next;
+    }
+    write_unlock_irqrestore(&g_int_lock, flags);
+    return (-1);
+}
+
+int irq_register(uint8_t irq, t_int_handler handler, void *ctx)
+{
+    if (irq >= IRQ_LINES ||
+        int_register((uint8_t)(IRQ_BASE + irq), handler, ctx) != 0)
+    {
+        return (-1);
+    }
+    g_irqchip->unmask(irq);
+    return (0);
+}
+
+int exception_register(uint8_t vector, t_int_handler handler, void *ctx)
+{
+    if (vector >= EXCEPTION_COUNT)
+    {
+        return (-1);
+    }
+    return (int_register(vector, handler, ctx));
+}
 
-            vtty_scroll_down(3);
+static bool_t int_run_handlers(t_regs *regs)
+{
+    const t_int_action  *action;
+    t_int_handler       handler;
+    void                *ctx;
+    bool_t              handled;
+
+    action = g_int_table[regs->vector];
+    handled = FALSE;
+    while (action != NULL)
+    {
+        handler = action->handler;
+        ctx = action->ctx;
+        if (handler(regs, ctx) == IRQ_HANDLED)
+        {
+            handled = TRUE;
         }
+        action = action->next;
     }
+    return (handled);
 }
 
-void irq_handler(uint32_t irq_num)
+static void msg_append(char *msg, const char *text)
 {
-    uint8_t irq;
+    k_strcpy(msg + k_strlen(msg), text);
+}
 
+static void msg_append_hex(char *msg, uint32_t value)
+{
+    char    number[12];
+
+    k_utoa(value, number, 16);
+    msg_append(msg, "0x");
+    msg_append(msg, number);
+}
+
+static void NORETURN exception_panic(const t_regs *regs)
+{
+    static char msg[160];
+    uint32_t    fault_addr;
+
+    msg[0] = '\0';
+    msg_append(msg, g_exception_names[regs->vector]);
+    msg_append(msg, " at EIP ");
+    msg_append_hex(msg, regs->eip);
+    msg_append(msg, ", error ");
+    msg_append_hex(msg, regs->err_code);
+    if (regs->vector == 14)
+    {
+        fault_addr = read_cr2();
+        msg_append(msg, ", address ");
+        msg_append_hex(msg, fault_addr);
+    }
+    KERNEL_PANIC(msg);
+}
+
+static void NORETURN double_fault_task(void)
+{
+    static char             msg[160];
+    const t_tss             *tss;
+    const t_stack_region    *region;
+    uint32_t                cpu;
+    uint32_t                fault_addr;
 
-    irq = (uint8_t)(irq_num - 32);
+    cpu = g_df_tss.prev_tss / 8 - GDT_TSS_BASE;
+    gdt_load_percpu(cpu, (uint32_t)percpu_get(cpu), sizeof(t_percpu));
+    tss = &smp_get_cpu(cpu)->tss;
+    fault_addr = read_cr2();
+    msg[0] = '\0';
+    msg_append(msg, "Double fault at EIP ");
+    msg_append_hex(msg, tss->eip);
+    msg_append(msg, ", ESP ");
+    msg_append_hex(msg, tss->esp);
+    msg_append(msg, ", address ");
+    msg_append_hex(msg, fault_addr);
+    region = stack_find(fault_addr + PAGE_SIZE);
+    if (region != NULL && region->guarded && fault_addr < region->base)
+    {
+        msg_append(msg, " (overflow of stack '");
+        msg_append(msg, region->name);
+        msg_append(msg, "')");
+    }
+    KERNEL_PANIC(msg);
+}
 
-    if (irq == 1)
+void __init double_fault_init(void)
+{
+    uint32_t    base;
+
+    base = stack_alloc("double_fault", DF_STACK_SIZE);
+    KERNEL_ASSERT(base != 0, "Cannot allocate the double fault stack");
+    k_memset(&g_df_tss, 0, sizeof(g_df_tss));
+    g_df_tss.cr3 = read_cr3();
+    g_df_tss.eip = (uint32_t)double_fault_task;
+    g_df_tss.eflags = 0x2;
+    g_df_tss.esp = base + DF_STACK_SIZE;
+    g_df_tss.cs = GDT_KERNEL_CODE;
+    g_df_tss.ss = GDT_KERNEL_DATA;
+    g_df_tss.ds = GDT_KERNEL_DATA;
+    g_df_tss.es = GDT_KERNEL_DATA;
+    g_df_tss.fs = GDT_KERNEL_DATA;
+    g_df_tss.gs = GDT_KERNEL_DATA;
+    g_df_tss.iomap_base = (uint16_t)sizeof(g_df_tss);
+    gdt_set_entry(GDT_DF_TSS, (uint32_t)&g_df_tss, sizeof(g_df_tss) - 1,
+                  GDT_TSS_ACCESS, 0);
+    idt_set_gate(EXCEPTION_DF, 0, GDT_DF_TSS_SELECTOR,
+                 IDT_FLAG_PRESENT | IDT_FLAG_DPL0 | IDT_GATE_TASK);
+}
+
+void isr_handler(t_regs *regs)
+{
+    if (!int_run_handlers(regs))
     {
-        handle_keyboard_irq();
+        exception_panic(regs);
     }
-    else if (irq == 12)
+}
+
+void irq_handler(t_regs *regs)
+{
+    if (g_irqchip->is_spurious(regs->vector))
+    {
+        return;
+    }
+    this_cpu_inc(irqs);
+    int_run_handlers(regs);
+    g_irqchip->eoi(regs->vector);
+}
+
+static int int_bench_handler(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+    return (IRQ_HANDLED);
+}
+
+static void int_bench_run(bool_t legacy, uint32_t iterations,
+                          uint32_t *min, uint32_t *avg)
+{
+    uint64_t    start;
+    uint64_t    total;
+    uint32_t    cycles;
+    uint32_t    i;
+
+    total = 0;
+    *min = 0xFFFFFFFFU;
+    for (i = 0; i < iterations; i++)
+    {
+        start = rdtsc();
+        if (legacy)
+        {
+            __asm__ volatile ("int %0" : : "i"(INT_BENCH_LEGACY_VECTOR) : "memory");
+        }
+        else
+        {
+            __asm__ volatile ("int %0" : : "i"(INT_BENCH_VECTOR) : "memory");
+        }
+        cycles = (uint32_t)(rdtsc() - start);
+        total += cycles;
+        if (cycles < *min)
+        {
+            *min = cycles;
+        }
+    }
+    *avg = (uint32_t)k_udivmod64(total, iterations, NULL);
+}
+
+void int_benchmark(uint32_t iterations)
+{
+    uint32_t    flags;
+    uint32_t    legacy_min;
+    uint32_t    legacy_avg;
+    uint32_t    new_min;
+    uint32_t    new_avg;
+
+    if (iterations == 0)
     {
-        handle_mouse_irq();
+        iterations = INT_BENCH_DEFAULT_ITERS;
     }
-    else
+    int_register(INT_BENCH_VECTOR, int_bench_handler, NULL);
+    int_register(INT_BENCH_LEGACY_VECTOR, int_bench_handler, NULL);
+    flags = irq_save();
+    int_bench_run(TRUE, iterations, &legacy_min, &legacy_avg);
+    int_bench_run(FALSE, iterations, &new_min, &new_avg);
+    irq_restore(flags);
+    int_unregister(INT_BENCH_VECTOR, int_bench_handler, NULL);
+    int_unregister(INT_BENCH_LEGACY_VECTOR, int_bench_handler, NULL);
+    printk("\n=== Interrupt entry/exit cost (%u x int, cycles) ===\n",
+           iterations);
+    printk("  legacy stub:      min %u  avg %u\n", legacy_min, legacy_avg);
+    printk("  streamlined stub: min %u  avg %u\n", new_min, new_avg);
+    if (legacy_avg > new_avg)
     {
-        pic_send_eoi(irq);
+        printk("  saved %u cycles per interrupt\n", legacy_avg - new_avg);
     }
+    printk("\n");
 }
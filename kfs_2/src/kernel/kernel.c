@@ -7,6 +7,18 @@
 #include "../include/vtty.h"
 #include "../include/shell.h"
 #include "../include/stack.h"
+#include "../include/multiboot.h"
+#include "../include/pmm.h"
+#include "../include/paging.h"
+#include "../include/softirq.h"
+#include "../include/irqchip.h"
+#include "../include/acpi.h"
+#include "../include/time.h"
+#include "../include/timer.h"
+#include "../include/cmdline.h"
+#include "../include/sched.h"
+#include "../include/smp.h"
+#include "../include/percpu.h"
 
 typedef __builtin_va_list   va_list;
 #define va_start(ap, last)  __builtin_va_start(ap, last)
@@ -18,6 +30,7 @@ void NORETURN kernel_panic(const char *file, int line, const char *msg)
     char line_str[12];
 
 
+    smp_stop_others();
     vga_set_color(vga_make_color(VGA_COLOR_WHITE, VGA_COLOR_RED));
     vga_clear();
 
@@ -45,6 +58,32 @@ void NORETURN kernel_panic(const char *file, int line, const char *msg)
     }
 }
 
+static void printk_lowercase(char *buffer)
+{
+    size_t i = 0;
+
+    while (buffer[i] != '\0')
+    {
+        if (buffer[i] >= 'A' && buffer[i] <= 'F')
+        {
+            buffer[i] = buffer[i] + ('a' - 'A');
+        }
+        i++;
+    }
+}
+
+static void printk_putnum64(uint64_t num, int base, int uppercase)
+{
+    char buffer[65];
+
+    k_u64toa(num, buffer, base);
+    if (!uppercase && base == 16)
+    {
+        printk_lowercase(buffer);
+    }
+    vtty_putstr(buffer);
+}
+
 static void printk_putnum(uint32_t num, int base, int is_signed, int uppercase)
 {
     char buffer[33];
@@ -59,15 +98,7 @@ static void printk_putnum(uint32_t num, int base, int is_signed, int uppercase)
     }
     if (!uppercase && base == 16)
     {
-        size_t i = 0;
-        while (buffer[i] != '\0')
-        {
-            if (buffer[i] >= 'A' && buffer[i] <= 'F')
-            {
-                buffer[i] = buffer[i] + ('a' - 'A');
-            }
-            i++;
-        }
+        printk_lowercase(buffer);
     }
     vtty_putstr(buffer);
 }
@@ -90,7 +121,25 @@ void printk(const char *format, ...)
         {
             i++;
             c = format[i];
-            if (c == 's')
+            if (c == 'l' && format[i + 1] == 'l' && format[i + 2] != '\0')
+            {
+                i += 2;
+                c = format[i];
+                if (c == 'u')
+                {
+                    printk_putnum64(va_arg(args, uint64_t), 10, 0);
+                }
+                else if (c == 'x' || c == 'X')
+                {
+                    printk_putnum64(va_arg(args, uint64_t), 16, c == 'X');
+                }
+                else
+                {
+                    vtty_putstr("%ll");
+                    vtty_putchar(c);
+                }
+            }
+            else if (c == 's')
             {
                 const char *s = va_arg(args, const char *);
                 vtty_putstr(s != NULL ? s : "(null)");
@@ -145,33 +194,101 @@ void printk(const char *format, ...)
     va_end(args);
 }
 
-static void display_42_banner(void)
+static const char   g_header_banner[] __initconst =
+    "===========================================\n"
+    "  " KERNEL_NAME " v" KERNEL_VERSION " - " KERNEL_AUTHOR "\n"
+    "===========================================\n";
+
+static const char   g_42_banner[] __initconst =
+    "\n"
+    "        ##   #####  \n"
+    "        ##  ##   ## \n"
+    "        ## ##     ##\n"
+    "   ##   ##       ## \n"
+    "   ##   ##      ##  \n"
+    "   ##   ##     ##   \n"
+    "   #######    ##    \n"
+    "        ##   ##     \n"
+    "        ##  ####### \n"
+    "\n";
+
+static const char   g_gdt_banner[] __initconst =
+    "GDT initialized at 0x800 with 7 segments\n"
+    "  [Kernel: Code/Data/Stack | User: Code/Data/Stack]\n";
+
+extern uint8_t      _init_start[];
+extern uint8_t      _init_end[];
+
+static void __init display_42_banner(void)
 {
     vtty_set_color(vga_make_color(VGA_COLOR_LIGHT_CYAN, VGA_COLOR_BLACK));
-    vtty_putstr("\n");
-    vtty_putstr("        ##   #####  \n");
-    vtty_putstr("        ##  ##   ## \n");
-    vtty_putstr("        ## ##     ##\n");
-    vtty_putstr("   ##   ##       ## \n");
-    vtty_putstr("   ##   ##      ##  \n");
-    vtty_putstr("   ##   ##     ##   \n");
-    vtty_putstr("   #######    ##    \n");
-    vtty_putstr("        ##   ##     \n");
-    vtty_putstr("        ##  ####### \n");
-    vtty_putstr("\n");
+    vtty_putstr(g_42_banner);
 }
 
-void kernel_main(void)
+static void __init display_boot_banner(void)
+{
+    vtty_set_color(vga_make_color(VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK));
+    vtty_putstr(g_header_banner);
+
+
+    display_42_banner();
+
+
+    vtty_set_color(vga_make_color(VGA_COLOR_YELLOW, VGA_COLOR_BLACK));
+    vtty_putstr(g_gdt_banner);
+    printk("Paging enabled (%s), %u MB free\n\n",
+           CONFIG_PAE ? "PAE" : "32-bit", pmm_free_frames() / 256);
+}
+
+static void kernel_free_init_memory(void)
+{
+    uint32_t    start;
+    uint32_t    end;
+    uint32_t    addr;
+    uint32_t    frames;
+
+    start = (uint32_t)_init_start;
+    end = (uint32_t)_init_end;
+
+
+    k_memset(_init_start, 0xCC, end - start);
+    for (addr = start; addr < end; addr += PAGE_SIZE)
+    {
+        paging_map(addr, addr, MAP_KERNEL_DATA);
+    }
+    frames = pmm_release_range(start, end - start);
+    printk("Freed %u KB of init memory\n\n", frames * (PAGE_SIZE / 1024));
+}
+
+void kernel_main(uint32_t magic, uint32_t mbi_addr)
 {
 
     vga_init();
 
 
     gdt_init();
+    percpu_init(0);
+
+
+    KERNEL_ASSERT(magic == MULTIBOOT_BOOTLOADER_MAGIC,
+                  "Not loaded by a multiboot bootloader");
+    cmdline_init((const t_multiboot_info *)mbi_addr);
+    pmm_init((const t_multiboot_info *)mbi_addr);
+    paging_init();
+    stack_init();
 
 
     pic_init();
     idt_init();
+    irq_stack_init();
+    double_fault_init();
+    softirq_init();
+    acpi_init();
+    irqchip_init();
+    timers_init();
+    time_init();
+    sched_init("shell");
+    smp_init();
 
 
     keyboard_init();
@@ -183,24 +300,7 @@ void kernel_main(void)
     vtty_init();
 
 
-    vtty_set_color(vga_make_color(VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK));
-    vtty_putstr("===========================================\n");
-    vtty_putstr("  ");
-    vtty_putstr(KERNEL_NAME);
-    vtty_putstr(" v");
-    vtty_putstr(KERNEL_VERSION);
-    vtty_putstr(" - ");
-    vtty_putstr(KERNEL_AUTHOR);
-    vtty_putstr("\n");
-    vtty_putstr("===========================================\n");
-
-
-    display_42_banner();
-
-
-    vtty_set_color(vga_make_color(VGA_COLOR_YELLOW, VGA_COLOR_BLACK));
-    vtty_putstr("GDT initialized at 0x800 with 7 segments\n");
-    vtty_putstr("  [Kernel: Code/Data/Stack | User: Code/Data/Stack]\n\n");
+    display_boot_banner();
 
 
     __asm__ volatile ("sti");
@@ -209,6 +309,7 @@ void kernel_main(void)
 
 
     shell_init();
+    kernel_free_init_memory();
     shell_run();
 
 
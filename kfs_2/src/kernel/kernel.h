@@ -22,6 +22,6 @@ void NORETURN kernel_panic(const char *file, int line, const char *msg);
 
 void printk(const char *format, ...);
 
-void kernel_main(void);
+void kernel_main(uint32_t magic, uint32_t mbi_addr);
 
 #endif
@@ -0,0 +1,102 @@
+#include "kernel.h"
+#include "../include/kthread.h"
+#include "../include/cpu.h"
+#include "../include/stack.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
+
+static volatile uint32_t    g_bench_left;
+
+t_task *kthread_create(const char *name, t_kthread_fn fn, void *arg)
+{
+    t_task      *task;
+    uint32_t    *sp;
+
+    task = task_alloc(name);
+    if (task == NULL)
+    {
+        return (NULL);
+    }
+    preempt_disable();
+    task->stack_base = stack_alloc(task->name, KTHREAD_STACK_SIZE);
+    preempt_enable();
+    if (task->stack_base == 0)
+    {
+        task->state = TASK_UNUSED;
+        return (NULL);
+    }
+    sp = (uint32_t *)(task->stack_base + KTHREAD_STACK_SIZE);
+    *--sp = 0;
+    *--sp = (uint32_t)kthread_trampoline;
+    *--sp = 0;
+    *--sp = (uint32_t)fn;
+    *--sp = (uint32_t)arg;
+    *--sp = 0;
+    task->esp = (uint32_t)sp;
+    sched_enqueue(task);
+    return (task);
+}
+
+void kthread_yield(void)
+{
+    schedule();
+}
+
+void NORETURN kthread_exit(void)
+{
+    sched_exit();
+}
+
+static void kthread_bench_fn(void *arg)
+{
+    (void)arg;
+
+    while (g_bench_left > 0)
+    {
+        g_bench_left--;
+        kthread_yield();
+    }
+}
+
+void kthread_benchmark(uint32_t iterations)
+{
+    uint64_t    start;
+    uint64_t    total;
+    uint64_t    best;
+    uint64_t    delta;
+    uint32_t    switches;
+
+    if (kthread_create("ctxbench", kthread_bench_fn, NULL) == NULL)
+    {
+        printk("ctxbench: cannot create thread\n");
+        return;
+    }
+    g_bench_left = iterations;
+    kthread_yield();
+    best = 0;
+    total = 0;
+    switches = sched_switch_count();
+    while (g_bench_left > 0)
+    {
+        start = rdtsc();
+        kthread_yield();
+        delta = rdtsc() - start;
+        total += delta;
+        if (best == 0 || delta < best)
+        {
+            best = delta;
+        }
+    }
+    switches = sched_switch_count() - switches;
+    kthread_yield();
+    if (switches == 0)
+    {
+        printk("ctxbench: no context switch happened\n");
+        return;
+    }
+    printk("Context switch (kthread_yield, %u switches):\n", switches);
+    printk("  avg  %llu cycles", k_udivmod64(total, switches, NULL));
+    printk(" (%llu ns)\n", cycles_to_ns(k_udivmod64(total, switches, NULL)));
+    printk("  best %llu cycles", best >> 1);
+    printk(" (%llu ns)\n", cycles_to_ns(best >> 1));
+}
@@ -0,0 +1,408 @@
+#include "paging.h"
+#include "cpu.h"
+#include "kernel.h"
+#include "smp.h"
+
+extern uint8_t  _text_start[];
+extern uint8_t  _text_end[];
+extern uint8_t  _init_start[];
+extern uint8_t  _init_end[];
+extern uint8_t  _kernel_end[];
+
+#if CONFIG_PAE
+static uint64_t g_pdpt[PAGING_PDPT_ENTRIES] ALIGNED(32);
+#endif
+static t_pte    g_page_dir[PAGING_PD_ENTRIES] ALIGNED(4096);
+
+static bool_t   g_paging_enabled;
+static bool_t   g_large_pages;
+static bool_t   g_global_pages;
+static bool_t   g_nx;
+static uint32_t g_direct_end;
+static uint32_t g_table_count;
+static uint32_t g_kmap_used;
+static t_spinlock g_kmap_lock = SPINLOCK_INIT("kmap");
+
+static ALWAYS_INLINE uint32_t pd_index(uint32_t virt)
+{
+    return (virt >> PAGING_PD_SHIFT);
+}
+
+static ALWAYS_INLINE uint32_t pt_index(uint32_t virt)
+{
+    return ((virt >> PAGE_SHIFT) & (PAGING_PT_ENTRIES - 1));
+}
+
+static ALWAYS_INLINE t_pte *pte_table(t_pte entry)
+{
+    return ((t_pte *)(uint32_t)(entry & PAGE_ADDR_MASK));
+}
+
+static ALWAYS_INLINE void paging_invalidate(uint32_t virt)
+{
+    if (g_paging_enabled)
+    {
+        invlpg(virt);
+    }
+}
+
+static t_pte paging_make_flags(uint32_t flags)
+{
+    t_pte   pte;
+
+    pte = PAGE_PRESENT;
+    if ((flags & MAP_WRITE) != 0)
+    {
+        pte |= PAGE_WRITE;
+    }
+    if ((flags & MAP_NOCACHE) != 0)
+    {
+        pte |= PAGE_PCD | PAGE_PWT;
+    }
+    if ((flags & MAP_GLOBAL) != 0 && g_global_pages)
+    {
+        pte |= PAGE_GLOBAL;
+    }
+    if ((flags & MAP_NOEXEC) != 0 && g_nx)
+    {
+        pte |= PAGE_NX;
+    }
+    return (pte);
+}
+
+static t_pte *paging_new_table(t_pte *pde)
+{
+    phys_addr_t frame;
+
+    frame = pmm_alloc_frame();
+    if (frame == 0)
+    {
+        return (NULL);
+    }
+    k_memset((void *)(uint32_t)frame, 0, PAGE_SIZE);
+    *pde = (t_pte)frame | PAGE_PRESENT | PAGE_WRITE;
+    g_table_count++;
+    return (pte_table(*pde));
+}
+
+static t_pte *paging_split_large(t_pte *pde, uint32_t virt)
+{
+    t_pte       large;
+    t_pte       flags;
+    t_pte       base;
+    t_pte       *table;
+    uint32_t    i;
+
+    large = *pde;
+    table = paging_new_table(pde);
+    KERNEL_ASSERT(table != NULL, "Out of memory splitting a large page");
+    base = large & PAGE_ADDR_MASK & ~(t_pte)(PAGING_LARGE_SIZE - 1);
+    flags = large & ~(PAGE_ADDR_MASK | PAGE_LARGE);
+    for (i = 0; i < PAGING_PT_ENTRIES; i++)
+    {
+        table[i] = (base + (t_pte)i * PAGE_SIZE) | flags;
+    }
+    paging_invalidate(virt & ~(PAGING_LARGE_SIZE - 1));
+    return (table);
+}
+
+static t_pte *paging_get_table(uint32_t virt, bool_t create)
+{
+    t_pte   *pde;
+
+    pde = &g_page_dir[pd_index(virt)];
+    if ((*pde & PAGE_PRESENT) == 0)
+    {
+        return (create ? paging_new_table(pde) : NULL);
+    }
+    if ((*pde & PAGE_LARGE) != 0)
+    {
+        return (paging_split_large(pde, virt));
+    }
+    return (pte_table(*pde));
+}
+
+int paging_map(uint32_t virt, phys_addr_t phys, uint32_t flags)
+{
+    t_pte   *table;
+
+    table = paging_get_table(virt, TRUE);
+    if (table == NULL)
+    {
+        return (-1);
+    }
+    table[pt_index(virt)] = ((t_pte)phys & PAGE_ADDR_MASK) |
+                            paging_make_flags(flags);
+    paging_invalidate(virt);
+    return (0);
+}
+
+void paging_unmap(uint32_t virt)
+{
+    t_pte   *table;
+
+    table = paging_get_table(virt, FALSE);
+    if (table == NULL)
+    {
+        return;
+    }
+    table[pt_index(virt)] = 0;
+    paging_invalidate(virt);
+    smp_tlb_shootdown(virt);
+}
+
+bool_t paging_is_mapped(uint32_t virt)
+{
+    t_pte   pde;
+
+    pde = g_page_dir[pd_index(virt)];
+    if ((pde & PAGE_PRESENT) == 0)
+    {
+        return (FALSE);
+    }
+    if ((pde & PAGE_LARGE) != 0)
+    {
+        return (TRUE);
+    }
+    return ((bool_t)((pte_table(pde)[pt_index(virt)] & PAGE_PRESENT) != 0));
+}
+
+phys_addr_t paging_virt_to_phys(uint32_t virt)
+{
+    t_pte   pde;
+    t_pte   pte;
+
+    pde = g_page_dir[pd_index(virt)];
+    if ((pde & PAGE_PRESENT) == 0)
+    {
+        return (0);
+    }
+    if ((pde & PAGE_LARGE) != 0)
+    {
+        return ((phys_addr_t)((pde & PAGE_ADDR_MASK &
+                               ~(t_pte)(PAGING_LARGE_SIZE - 1)) |
+                              (virt & (PAGING_LARGE_SIZE - 1))));
+    }
+    pte = pte_table(pde)[pt_index(virt)];
+    if ((pte & PAGE_PRESENT) == 0)
+    {
+        return (0);
+    }
+    return ((phys_addr_t)((pte & PAGE_ADDR_MASK) | (virt & PAGE_MASK)));
+}
+
+static uint32_t __init paging_direct_flags(uint32_t addr)
+{
+    if (addr < PMM_RESERVED_LOW ||
+        (addr >= (uint32_t)_text_start && addr < (uint32_t)_text_end) ||
+        (addr >= (uint32_t)_init_start && addr < (uint32_t)_init_end))
+    {
+        return (MAP_WRITE | MAP_GLOBAL);
+    }
+    return (MAP_KERNEL_DATA);
+}
+
+static void __init paging_map_direct(void)
+{
+    uint32_t    addr;
+    uint32_t    small_end;
+
+    g_direct_end = pmm_lowmem_end();
+    small_end = g_direct_end;
+    if (g_large_pages)
+    {
+        small_end = ((uint32_t)_kernel_end + PAGING_LARGE_SIZE - 1) &
+                    ~(PAGING_LARGE_SIZE - 1);
+        if (small_end > g_direct_end)
+        {
+            small_end = g_direct_end;
+        }
+    }
+
+    for (addr = 0; addr < small_end; addr += PAGE_SIZE)
+    {
+        KERNEL_ASSERT(paging_map(addr, addr, paging_direct_flags(addr)) == 0,
+                      "Out of memory building the direct map");
+    }
+    while (g_large_pages && addr + PAGING_LARGE_SIZE <= g_direct_end &&
+           addr + PAGING_LARGE_SIZE > addr)
+    {
+        g_page_dir[pd_index(addr)] = (t_pte)addr | PAGE_LARGE |
+                                     paging_make_flags(MAP_KERNEL_DATA);
+        addr += PAGING_LARGE_SIZE;
+    }
+    for (; addr < g_direct_end; addr += PAGE_SIZE)
+    {
+        KERNEL_ASSERT(paging_map(addr, addr, MAP_KERNEL_DATA) == 0,
+                      "Out of memory building the direct map");
+    }
+}
+
+static void __init paging_detect_features(void)
+{
+    t_cpuid_regs    features;
+
+    features = cpuid(1, 0);
+    g_global_pages = (bool_t)((features.edx & CPUID_FEAT_EDX_PGE) != 0);
+#if CONFIG_PAE
+    KERNEL_ASSERT((features.edx & CPUID_FEAT_EDX_PAE) != 0,
+                  "Kernel built with PAE=1 but the CPU lacks PAE");
+    g_large_pages = TRUE;
+    g_nx = FALSE;
+    if (cpuid_max_extended() >= 0x80000001 &&
+        (cpuid(0x80000001, 0).edx & CPUID_EXT_EDX_NX) != 0)
+    {
+        wrmsr(MSR_EFER, rdmsr(MSR_EFER) | EFER_NXE);
+        g_nx = TRUE;
+    }
+#else
+    g_large_pages = (bool_t)((features.edx & CPUID_FEAT_EDX_PSE) != 0);
+    g_nx = FALSE;
+#endif
+}
+
+void __init paging_init(void)
+{
+    paging_detect_features();
+    k_memset(g_page_dir, 0, sizeof(g_page_dir));
+    g_table_count = 0;
+    g_kmap_used = 0;
+    paging_map_direct();
+
+#if CONFIG_PAE
+    {
+        uint32_t    i;
+
+        for (i = 0; i < PAGING_PDPT_ENTRIES; i++)
+        {
+            g_pdpt[i] = (uint64_t)(uint32_t)&g_page_dir[i * PAGING_PT_ENTRIES] |
+                        PAGE_PRESENT;
+        }
+    }
+    write_cr4(read_cr4() | CR4_PAE);
+    write_cr3((uint32_t)g_pdpt);
+#else
+    if (g_large_pages)
+    {
+        write_cr4(read_cr4() | CR4_PSE);
+    }
+    write_cr3((uint32_t)g_page_dir);
+#endif
+    write_cr0(read_cr0() | CR0_PG);
+    if (g_global_pages)
+    {
+        write_cr4(read_cr4() | CR4_PGE);
+    }
+    g_paging_enabled = TRUE;
+}
+
+void *paging_map_mmio(phys_addr_t phys, uint32_t size)
+{
+    uint64_t    addr;
+    uint64_t    end;
+
+    end = (uint64_t)phys + size;
+    if (end > 0x100000000ULL ||
+        (end > KMAP_BASE &&
+         (uint64_t)phys < KMAP_BASE + KMAP_SLOTS * PAGE_SIZE))
+    {
+        return (NULL);
+    }
+    addr = (uint64_t)phys & ~(uint64_t)PAGE_MASK;
+    for (; addr < end; addr += PAGE_SIZE)
+    {
+        if (addr < g_direct_end)
+        {
+            continue;
+        }
+        if (paging_map((uint32_t)addr, (phys_addr_t)addr, MAP_MMIO) != 0)
+        {
+            return (NULL);
+        }
+    }
+    return ((void *)(uint32_t)phys);
+}
+
+void *paging_kmap(phys_addr_t frame)
+{
+    uint32_t    flags;
+    uint32_t    slot;
+    uint32_t    virt;
+
+    frame &= ~(phys_addr_t)PAGE_MASK;
+    if ((uint64_t)frame + PAGE_SIZE <= g_direct_end)
+    {
+        return ((void *)(uint32_t)frame);
+    }
+    flags = spin_lock_irqsave(&g_kmap_lock);
+    for (slot = 0; slot < KMAP_SLOTS; slot++)
+    {
+        if ((g_kmap_used & (1U << slot)) == 0)
+        {
+            virt = KMAP_BASE + slot * PAGE_SIZE;
+            if (paging_map(virt, frame, MAP_WRITE | MAP_NOEXEC) != 0)
+            {
+                break;
+            }
+            g_kmap_used |= (1U << slot);
+            spin_unlock_irqrestore(&g_kmap_lock, flags);
+            return ((void *)virt);
+        }
+    }
+    spin_unlock_irqrestore(&g_kmap_lock, flags);
+    return (NULL);
+}
+
+void paging_kunmap(void *addr)
+{
+    uint32_t    flags;
+    uint32_t    virt;
+    uint32_t    slot;
+
+    virt = (uint32_t)addr & ~(uint32_t)PAGE_MASK;
+    if (virt < KMAP_BASE || virt >= KMAP_BASE + KMAP_SLOTS * PAGE_SIZE)
+    {
+        return;
+    }
+    slot = (virt - KMAP_BASE) / PAGE_SIZE;
+    paging_unmap(virt);
+    flags = spin_lock_irqsave(&g_kmap_lock);
+    g_kmap_used &= ~(1U << slot);
+    spin_unlock_irqrestore(&g_kmap_lock, flags);
+}
+
+bool_t paging_enabled(void)
+{
+    return (g_paging_enabled);
+}
+
+bool_t paging_nx_enabled(void)
+{
+    return (g_nx);
+}
+
+void paging_print(void)
+{
+    uint32_t    used;
+    uint32_t    slot;
+
+    used = 0;
+    for (slot = 0; slot < KMAP_SLOTS; slot++)
+    {
+        if ((g_kmap_used & (1U << slot)) != 0)
+        {
+            used++;
+        }
+    }
+    printk("=== Paging ===\n");
+    printk("Mode:        %s\n", CONFIG_PAE ? "PAE (3-level, 64-bit entries)"
+                                           : "32-bit (2-level)");
+    printk("Large pages: %s (%u KB)\n", g_large_pages ? "yes" : "no",
+           PAGING_LARGE_SIZE / 1024);
+    printk("Global:      %s\n", g_global_pages ? "yes" : "no");
+    printk("NX:          %s\n", g_nx ? "enabled" : "unavailable");
+    printk("Direct map:  0x0 - 0x%x\n", g_direct_end);
+    printk("Page tables: %u\n", g_table_count);
+    printk("Kmap slots:  %u in use of %u\n", used, KMAP_SLOTS);
+    printk("\n");
+}
@@ -0,0 +1,30 @@
+#include "kernel.h"
+#include "../include/percpu.h"
+#include "../include/gdt.h"
+
+STATIC_ASSERT(GDT_PERCPU_SELECTOR(0) - GDT_TSS_SELECTOR(0) == TSS_TO_PERCPU,
+              percpu_selector_follows_tss_by_16_entries);
+
+static t_percpu     g_percpu[GDT_MAX_CPUS];
+
+void percpu_init(uint32_t cpu)
+{
+    t_percpu    *area;
+
+    KERNEL_ASSERT(cpu < GDT_MAX_CPUS, "No per-CPU area for this CPU");
+    area = &g_percpu[cpu];
+    area->self = area;
+    area->cpu = cpu;
+    area->tasklet_head = NULL;
+    area->tasklet_tail = &area->tasklet_head;
+    gdt_load_percpu(cpu, (uint32_t)area, sizeof(*area));
+}
+
+t_percpu *percpu_get(uint32_t cpu)
+{
+    if (cpu >= GDT_MAX_CPUS)
+    {
+        return (NULL);
+    }
+    return (&g_percpu[cpu]);
+}
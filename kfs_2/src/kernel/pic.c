@@ -1,4 +1,7 @@
 #include "../include/pic.h"
+#include "../include/cpu.h"
+#include "../include/irqchip.h"
+#include "../include/idt.h"
 
 static inline void outb(uint16_t port, uint8_t value)
 {
@@ -12,12 +15,15 @@ static inline uint8_t inb(uint16_t port)
     return (ret);
 }
 
+static uint16_t g_pic_mask = 0xFFFF;
+static uint32_t g_pic_spurious[2];
+
 static inline void io_wait(void)
 {
     outb(0x80, 0);
 }
 
-void pic_init(void)
+void __init pic_init(void)
 {
 
     outb(PIC1_COMMAND, (uint8_t)(ICW1_INIT | ICW1_ICW4));
@@ -44,8 +50,13 @@ void pic_init(void)
     io_wait();
 
 
+    g_pic_mask = 0xFFFF;
     outb(PIC1_DATA, 0xFF);
     outb(PIC2_DATA, 0xFF);
+
+
+    outb(PIC1_COMMAND, PIC_OCW3_READ_ISR);
+    outb(PIC2_COMMAND, PIC_OCW3_READ_ISR);
 }
 
 void pic_send_eoi(uint8_t irq)
@@ -57,42 +68,110 @@ void pic_send_eoi(uint8_t irq)
     outb(PIC1_COMMAND, PIC_EOI);
 }
 
-void pic_set_mask(uint8_t irq)
+void pic_update_mask(uint16_t set_bits, uint16_t clear_bits)
 {
-    uint16_t    port;
-    uint8_t     value;
+    uint32_t    flags;
+    uint16_t    mask;
+    uint16_t    changed;
 
-    if (irq < 8)
+    if ((clear_bits & 0xFF00) != 0)
     {
-        port = PIC1_DATA;
+        clear_bits = (uint16_t)(clear_bits | (1U << PIC_CASCADE_IRQ));
     }
-    else
+    flags = irq_save();
+    mask = (uint16_t)((g_pic_mask | set_bits) & ~clear_bits);
+    changed = (uint16_t)(mask ^ g_pic_mask);
+    g_pic_mask = mask;
+    if ((changed & 0x00FF) != 0)
     {
-        port = PIC2_DATA;
-        irq = (uint8_t)(irq - 8);
+        outb(PIC1_DATA, (uint8_t)(mask & 0xFF));
     }
+    if ((changed & 0xFF00) != 0)
+    {
+        outb(PIC2_DATA, (uint8_t)(mask >> 8));
+    }
+    irq_restore(flags);
+}
 
-    value = inb(port);
-    value = (uint8_t)(value | (1U << irq));
-    outb(port, value);
+uint16_t pic_get_mask(void)
+{
+    return (g_pic_mask);
+}
+
+void pic_set_mask(uint8_t irq)
+{
+    pic_update_mask((uint16_t)(1U << irq), 0);
 }
 
 void pic_clear_mask(uint8_t irq)
 {
-    uint16_t    port;
-    uint8_t     value;
+    pic_update_mask(0, (uint16_t)(1U << irq));
+}
+
+bool_t pic_is_spurious(uint8_t irq)
+{
+    if (irq == 7)
+    {
+        if ((inb(PIC1_COMMAND) & 0x80) != 0)
+        {
+            return (FALSE);
+        }
+        g_pic_spurious[0]++;
+        return (TRUE);
+    }
+    if (irq == 15)
+    {
+        if ((inb(PIC2_COMMAND) & 0x80) != 0)
+        {
+            return (FALSE);
+        }
+        outb(PIC1_COMMAND, PIC_EOI);
+        g_pic_spurious[1]++;
+        return (TRUE);
+    }
+    return (FALSE);
+}
 
-    if (irq < 8)
+uint32_t pic_spurious_count(uint8_t irq)
+{
+    if (irq == 7)
     {
-        port = PIC1_DATA;
+        return (g_pic_spurious[0]);
     }
-    else
+    if (irq == 15)
     {
-        port = PIC2_DATA;
-        irq = (uint8_t)(irq - 8);
+        return (g_pic_spurious[1]);
     }
+    return (0);
+}
 
-    value = inb(port);
-    value = (uint8_t)(value & ~(1U << irq));
-    outb(port, value);
+void pic_reset_spurious(void)
+{
+    g_pic_spurious[0] = 0;
+    g_pic_spurious[1] = 0;
 }
+
+static void pic_chip_eoi(uint32_t vector)
+{
+    if (vector >= IRQ_BASE && vector < IRQ_BASE + IRQ_LINES)
+    {
+        pic_send_eoi((uint8_t)(vector - IRQ_BASE));
+    }
+}
+
+static bool_t pic_chip_is_spurious(uint32_t vector)
+{
+    if (vector == IRQ_BASE + 7 || vector == IRQ_BASE + 15)
+    {
+        return (pic_is_spurious((uint8_t)(vector - IRQ_BASE)));
+    }
+    return (FALSE);
+}
+
+const t_irqchip g_pic_chip = {
+    "8259 PIC",
+    pic_set_mask,
+    pic_clear_mask,
+    pic_chip_eoi,
+    pic_chip_is_spurious
+};
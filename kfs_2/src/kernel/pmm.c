@@ -0,0 +1,435 @@
+#include "pmm.h"
+#include "kernel.h"
+
+extern uint8_t  _kernel_end[];
+
+static uint32_t     *g_bitmap;
+static uint32_t     g_bitmap_bytes;
+static uint32_t     g_frame_limit;
+static uint32_t     g_lowmem_frames;
+static uint32_t     g_total_frames;
+static uint32_t     g_free_frames;
+static uint32_t     g_low_hint;
+static uint32_t     g_high_hint;
+static uint64_t     g_ignored_bytes;
+
+static t_pmm_region g_regions[PMM_MAX_REGIONS];
+static uint32_t     g_region_count;
+
+static ALWAYS_INLINE bool_t frame_test(uint32_t frame)
+{
+    return ((bool_t)((g_bitmap[frame >> 5] >> (frame & 31)) & 1U));
+}
+
+static ALWAYS_INLINE void frame_set(uint32_t frame)
+{
+    g_bitmap[frame >> 5] |= (1U << (frame & 31));
+}
+
+static ALWAYS_INLINE void frame_clear(uint32_t frame)
+{
+    g_bitmap[frame >> 5] &= ~(1U << (frame & 31));
+}
+
+static ALWAYS_INLINE uint64_t align_up64(uint64_t value)
+{
+    return ((value + PAGE_MASK) & ~(uint64_t)PAGE_MASK);
+}
+
+static ALWAYS_INLINE uint64_t align_down64(uint64_t value)
+{
+    return (value & ~(uint64_t)PAGE_MASK);
+}
+
+static void __init pmm_add_region(uint64_t base, uint64_t length, uint32_t type)
+{
+    if (length == 0 || g_region_count >= PMM_MAX_REGIONS)
+    {
+        return;
+    }
+    g_regions[g_region_count].base = base;
+    g_regions[g_region_count].length = length;
+    g_regions[g_region_count].type = type;
+    g_region_count++;
+}
+
+static void __init pmm_collect_regions(const t_multiboot_info *mbi)
+{
+    const t_multiboot_mmap_entry    *entry;
+    uint32_t                        addr;
+    uint32_t                        end;
+
+    g_region_count = 0;
+    if ((mbi->flags & MULTIBOOT_INFO_MEM_MAP) != 0)
+    {
+        addr = mbi->mmap_addr;
+        end = mbi->mmap_addr + mbi->mmap_length;
+        while (addr + sizeof(t_multiboot_mmap_entry) <= end)
+        {
+            entry = (const t_multiboot_mmap_entry *)addr;
+            pmm_add_region(entry->addr, entry->len, entry->type);
+            addr += entry->size + (uint32_t)sizeof(entry->size);
+        }
+    }
+    else if ((mbi->flags & MULTIBOOT_INFO_MEMORY) != 0)
+    {
+        pmm_add_region(0, (uint64_t)mbi->mem_lower * 1024,
+                       MULTIBOOT_MEMORY_AVAILABLE);
+        pmm_add_region(PMM_RESERVED_LOW, (uint64_t)mbi->mem_upper * 1024,
+                       MULTIBOOT_MEMORY_AVAILABLE);
+    }
+    KERNEL_ASSERT(g_region_count > 0, "No memory map from bootloader");
+}
+
+static uint32_t __init pmm_boot_data_end(const t_multiboot_info *mbi)
+{
+    const t_multiboot_module    *mods;
+    uint32_t                    end;
+    uint32_t                    i;
+
+    end = (uint32_t)mbi + sizeof(t_multiboot_info);
+    if ((mbi->flags & MULTIBOOT_INFO_MEM_MAP) != 0 &&
+        mbi->mmap_addr + mbi->mmap_length > end)
+    {
+        end = mbi->mmap_addr + mbi->mmap_length;
+    }
+    if ((mbi->flags & MULTIBOOT_INFO_CMDLINE) != 0 &&
+        mbi->cmdline + k_strlen((const char *)mbi->cmdline) + 1 > end)
+    {
+        end = mbi->cmdline + k_strlen((const char *)mbi->cmdline) + 1;
+    }
+    if ((mbi->flags & MULTIBOOT_INFO_MODS) != 0)
+    {
+        mods = (const t_multiboot_module *)mbi->mods_addr;
+        if (mbi->mods_addr + mbi->mods_count * sizeof(*mods) > end)
+        {
+            end = mbi->mods_addr + mbi->mods_count * sizeof(*mods);
+        }
+        for (i = 0; i < mbi->mods_count; i++)
+        {
+            if (mods[i].mod_end > end)
+            {
+                end = mods[i].mod_end;
+            }
+        }
+    }
+    return (end);
+}
+
+static uint32_t __init pmm_place_bitmap(uint32_t min_addr, uint32_t size)
+{
+    uint64_t    start;
+    uint64_t    end;
+    uint32_t    i;
+
+    for (i = 0; i < g_region_count; i++)
+    {
+        if (g_regions[i].type != MULTIBOOT_MEMORY_AVAILABLE)
+        {
+            continue;
+        }
+        start = align_up64(g_regions[i].base);
+        if (start < min_addr)
+        {
+            start = min_addr;
+        }
+        end = g_regions[i].base + g_regions[i].length;
+        if (start + size <= end && start + size <= PMM_LOWMEM_LIMIT)
+        {
+            return ((uint32_t)start);
+        }
+    }
+    KERNEL_PANIC("No room for the physical frame bitmap");
+}
+
+static void __init pmm_size_tracking(void)
+{
+    uint64_t    end;
+    uint64_t    highest;
+    uint64_t    low_end;
+    uint32_t    i;
+
+    highest = 0;
+    low_end = 0;
+    g_ignored_bytes = 0;
+    for (i = 0; i < g_region_count; i++)
+    {
+        if (g_regions[i].type != MULTIBOOT_MEMORY_AVAILABLE)
+        {
+            continue;
+        }
+        end = g_regions[i].base + g_regions[i].length;
+        if (end > PMM_MAX_PHYS)
+        {
+            g_ignored_bytes += end - (g_regions[i].base > PMM_MAX_PHYS
+                                      ? g_regions[i].base : PMM_MAX_PHYS);
+            end = PMM_MAX_PHYS;
+        }
+        if (end > highest)
+        {
+            highest = end;
+        }
+        if (g_regions[i].base < PMM_LOWMEM_LIMIT)
+        {
+            if (end > PMM_LOWMEM_LIMIT)
+            {
+                end = PMM_LOWMEM_LIMIT;
+            }
+            if (end > low_end)
+            {
+                low_end = end;
+            }
+        }
+    }
+    g_frame_limit = (uint32_t)(align_down64(highest) >> PAGE_SHIFT);
+    g_lowmem_frames = (uint32_t)(align_down64(low_end) >> PAGE_SHIFT);
+}
+
+void __init pmm_init(const t_multiboot_info *mbi)
+{
+    uint32_t    min_addr;
+    uint32_t    i;
+
+    pmm_collect_regions(mbi);
+    pmm_size_tracking();
+
+    g_bitmap_bytes = ((g_frame_limit + 31) / 32) * (uint32_t)sizeof(uint32_t);
+    min_addr = (uint32_t)_kernel_end;
+    if (pmm_boot_data_end(mbi) > min_addr)
+    {
+        min_addr = pmm_boot_data_end(mbi);
+    }
+    min_addr = (min_addr + PAGE_MASK) & ~(uint32_t)PAGE_MASK;
+    g_bitmap = (uint32_t *)pmm_place_bitmap(min_addr, g_bitmap_bytes);
+    k_memset(g_bitmap, 0xFF, g_bitmap_bytes);
+
+    g_free_frames = 0;
+    for (i = 0; i < g_region_count; i++)
+    {
+        if (g_regions[i].type == MULTIBOOT_MEMORY_AVAILABLE)
+        {
+            pmm_release_range(g_regions[i].base, g_regions[i].length);
+        }
+    }
+    g_total_frames = g_free_frames;
+    for (i = 0; i < g_region_count; i++)
+    {
+        if (g_regions[i].type != MULTIBOOT_MEMORY_AVAILABLE)
+        {
+            pmm_reserve_range(g_regions[i].base, g_regions[i].length);
+        }
+    }
+
+    pmm_reserve_range(0, PMM_RESERVED_LOW);
+    pmm_reserve_range(PMM_RESERVED_LOW,
+                      (uint32_t)_kernel_end - PMM_RESERVED_LOW);
+    pmm_reserve_range((uint32_t)mbi, pmm_boot_data_end(mbi) - (uint32_t)mbi);
+    pmm_reserve_range((uint32_t)g_bitmap, g_bitmap_bytes);
+
+    g_low_hint = 0;
+    g_high_hint = g_lowmem_frames >> 5;
+}
+
+void pmm_reserve_range(uint64_t base, uint64_t length)
+{
+    uint64_t    first;
+    uint64_t    last;
+
+    first = align_down64(base) >> PAGE_SHIFT;
+    last = align_up64(base + length) >> PAGE_SHIFT;
+    if (last > g_frame_limit)
+    {
+        last = g_frame_limit;
+    }
+    while (first < last)
+    {
+        if (!frame_test((uint32_t)first))
+        {
+            frame_set((uint32_t)first);
+            g_free_frames--;
+        }
+        first++;
+    }
+}
+
+uint32_t pmm_release_range(uint64_t base, uint64_t length)
+{
+    uint64_t    first;
+    uint64_t    last;
+    uint32_t    released;
+
+    first = align_up64(base) >> PAGE_SHIFT;
+    last = align_down64(base + length) >> PAGE_SHIFT;
+    if (last > g_frame_limit)
+    {
+        last = g_frame_limit;
+    }
+    released = 0;
+    while (first < last)
+    {
+        if (frame_test((uint32_t)first))
+        {
+            frame_clear((uint32_t)first);
+            g_free_frames++;
+            released++;
+        }
+        first++;
+    }
+    return (released);
+}
+
+static uint32_t pmm_find_free(uint32_t first_frame, uint32_t end_frame,
+                              uint32_t *hint)
+{
+    uint32_t    first_word;
+    uint32_t    end_word;
+    uint32_t    word;
+    uint32_t    scanned;
+    uint32_t    avail;
+    uint32_t    frame;
+
+    if (end_frame <= first_frame)
+    {
+        return (0);
+    }
+    first_word = first_frame >> 5;
+    end_word = (end_frame + 31) >> 5;
+    word = *hint;
+    if (word < first_word || word >= end_word)
+    {
+        word = first_word;
+    }
+    scanned = 0;
+    while (scanned < end_word - first_word)
+    {
+        avail = ~g_bitmap[word];
+        while (avail != 0)
+        {
+            frame = (word << 5) + (uint32_t)__builtin_ctz(avail);
+            if (frame >= first_frame && frame < end_frame)
+            {
+                *hint = word;
+                return (frame);
+            }
+            avail &= avail - 1;
+        }
+        word++;
+        if (word >= end_word)
+        {
+            word = first_word;
+        }
+        scanned++;
+    }
+    return (0);
+}
+
+phys_addr_t pmm_alloc_frame(void)
+{
+    uint32_t    frame;
+
+    frame = pmm_find_free(0, g_lowmem_frames, &g_low_hint);
+    if (frame == 0)
+    {
+        return (0);
+    }
+    frame_set(frame);
+    g_free_frames--;
+    return ((phys_addr_t)frame << PAGE_SHIFT);
+}
+
+phys_addr_t pmm_alloc_frame_high(void)
+{
+    uint32_t    frame;
+
+    frame = pmm_find_free(g_lowmem_frames, g_frame_limit, &g_high_hint);
+    if (frame == 0)
+    {
+        return (pmm_alloc_frame());
+    }
+    frame_set(frame);
+    g_free_frames--;
+    return ((phys_addr_t)frame << PAGE_SHIFT);
+}
+
+void pmm_free_frame(phys_addr_t frame)
+{
+    uint32_t    index;
+
+    index = (uint32_t)(frame >> PAGE_SHIFT);
+    KERNEL_ASSERT(index != 0 && index < g_frame_limit,
+                  "pmm_free_frame: frame out of range");
+    KERNEL_ASSERT(frame_test(index), "pmm_free_frame: double free");
+    frame_clear(index);
+    g_free_frames++;
+    if ((index >> 5) < g_low_hint && index < g_lowmem_frames)
+    {
+        g_low_hint = index >> 5;
+    }
+}
+
+uint32_t pmm_free_frames(void)
+{
+    return (g_free_frames);
+}
+
+uint32_t pmm_total_frames(void)
+{
+    return (g_total_frames);
+}
+
+uint32_t pmm_lowmem_end(void)
+{
+    return (g_lowmem_frames << PAGE_SHIFT);
+}
+
+static const char *pmm_region_name(uint32_t type)
+{
+    if (type == MULTIBOOT_MEMORY_AVAILABLE)
+        return ("Available");
+    if (type == MULTIBOOT_MEMORY_ACPI)
+        return ("ACPI reclaimable");
+    if (type == MULTIBOOT_MEMORY_NVS)
+        return ("ACPI NVS");
+    if (type == MULTIBOOT_MEMORY_BADRAM)
+        return ("Bad RAM");
+    return ("Reserved");
+}
+
+void pmm_print(void)
+{
+    uint32_t    high_free;
+    uint32_t    frame;
+    uint32_t    i;
+
+    printk("\n=== Physical Memory ===\n");
+    printk("Memory map (%u entries):\n", g_region_count);
+    for (i = 0; i < g_region_count; i++)
+    {
+        printk("  0x%llx - 0x%llx  %s\n", g_regions[i].base,
+               g_regions[i].base + g_regions[i].length - 1,
+               pmm_region_name(g_regions[i].type));
+    }
+
+    high_free = 0;
+    for (frame = g_lowmem_frames; frame < g_frame_limit; frame++)
+    {
+        if (!frame_test(frame))
+        {
+            high_free++;
+        }
+    }
+
+    printk("\nFrames:   %u total (%u MB), %u free (%u MB)\n",
+           g_total_frames, g_total_frames / 256,
+           g_free_frames, g_free_frames / 256);
+    printk("Lowmem:   direct-mapped up to 0x%x\n", pmm_lowmem_end());
+    printk("Highmem:  %u free frames (%u MB) via kmap\n",
+           high_free, high_free / 256);
+    printk("Bitmap:   %p (%u KB)\n", (void *)g_bitmap, g_bitmap_bytes / 1024);
+    if (g_ignored_bytes != 0)
+    {
+        printk("Ignored:  %llu KB above the %s physical limit\n",
+               g_ignored_bytes >> 10, CONFIG_PAE ? "64 GB" : "4 GB");
+    }
+    printk("\n");
+}
@@ -0,0 +1,475 @@
+#include "kernel.h"
+#include "../include/sched.h"
+#include "../include/kthread.h"
+#include "../include/idt.h"
+#include "../include/cpu.h"
+#include "../include/stack.h"
+#include "../include/softirq.h"
+#include "../include/tick.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
+
+static t_task               g_tasks[TASK_MAX];
+static uint32_t             g_next_pid;
+static t_list               g_runqueues[SCHED_PRIO_LEVELS];
+static uint32_t             g_prio_bitmap;
+static uint32_t             g_prio_slice[SCHED_PRIO_LEVELS];
+static uint32_t             g_switches;
+static t_task               *g_task_dead;
+
+static const char *const    g_task_state_names[] = {
+    "unused", "running", "ready", "blocked", "dead"
+};
+
+static ALWAYS_INLINE bool_t sched_atomic(void)
+{
+    return ((bool_t)(this_cpu_read(preempt_count) != 0 ||
+                     this_cpu_read(irq_depth) != 0 || in_softirq()));
+}
+
+static ALWAYS_INLINE uint32_t prio_mask(uint32_t prio)
+{
+    return ((2U << prio) - 1);
+}
+
+static ALWAYS_INLINE void runqueue_add(t_task *task)
+{
+    if (task->policy == SCHED_DEADLINE)
+    {
+        dl_enqueue(task);
+        return;
+    }
+    list_add_tail(&task->run_node, &g_runqueues[task->prio]);
+    g_prio_bitmap |= 1U << task->prio;
+}
+
+static ALWAYS_INLINE void runqueue_del(t_task *task)
+{
+    if (task->policy == SCHED_DEADLINE)
+    {
+        dl_dequeue(task);
+        return;
+    }
+    list_del(&task->run_node);
+    if (list_empty(&g_runqueues[task->prio]))
+    {
+        g_prio_bitmap &= ~(1U << task->prio);
+    }
+}
+
+static ALWAYS_INLINE t_task *runqueue_pick(void)
+{
+    uint32_t    prio;
+    t_task      *task;
+
+    task = dl_pick();
+    if (task != NULL)
+    {
+        return (task);
+    }
+    prio = (uint32_t)__builtin_ctz(g_prio_bitmap);
+    return (LIST_ENTRY(g_runqueues[prio].next, t_task, run_node));
+}
+
+static ALWAYS_INLINE bool_t task_preempts(const t_task *task,
+                                          const t_task *curr)
+{
+    if (task->policy == SCHED_DEADLINE)
+    {
+        return ((bool_t)(curr->policy != SCHED_DEADLINE ||
+                         task->dl_abs_deadline < curr->dl_abs_deadline));
+    }
+    if (curr->policy == SCHED_DEADLINE)
+    {
+        return (FALSE);
+    }
+    return ((bool_t)(task->prio < curr->prio));
+}
+
+t_task *task_alloc(const char *name)
+{
+    t_task      *task;
+    uint32_t    flags;
+    uint32_t    i;
+
+    flags = irq_save();
+    for (i = 0; i < TASK_MAX; i++)
+    {
+        if (g_tasks[i].state == TASK_UNUSED)
+        {
+            break;
+        }
+    }
+    if (i == TASK_MAX)
+    {
+        irq_restore(flags);
+        return (NULL);
+    }
+    task = &g_tasks[i];
+    k_memset(task, 0, sizeof(*task));
+    task->state = TASK_READY;
+    task->pid = g_next_pid++;
+    irq_restore(flags);
+    k_strncpy(task->name, name, TASK_NAME_LEN - 1);
+    task->prio = SCHED_PRIO_DEFAULT;
+    task->slice = g_prio_slice[task->prio];
+    list_init(&task->run_node);
+    return (task);
+}
+
+t_task *task_get(uint32_t index)
+{
+    if (index >= TASK_MAX || g_tasks[index].state == TASK_UNUSED)
+    {
+        return (NULL);
+    }
+    return (&g_tasks[index]);
+}
+
+const char *task_state_name(uint32_t state)
+{
+    if (state > TASK_DEAD)
+    {
+        return ("?");
+    }
+    return (g_task_state_names[state]);
+}
+
+uint32_t sched_timeslice(uint32_t prio)
+{
+    return (g_prio_slice[prio]);
+}
+
+static void sched_idle(void *arg)
+{
+    (void)arg;
+
+    while (1)
+    {
+        do_softirq();
+        __asm__ volatile ("cli");
+        if (this_cpu_read(need_resched) == 0 &&
+            this_cpu_read(softirq_pending) == 0)
+        {
+            cpu_idle();
+        }
+        else
+        {
+            __asm__ volatile ("sti");
+        }
+        if (this_cpu_read(need_resched) != 0)
+        {
+            schedule();
+        }
+    }
+}
+
+void __init sched_init(const char *name)
+{
+    t_task      *boot;
+    t_task      *idle;
+    uint32_t    ms;
+    uint32_t    prio;
+
+    for (prio = 0; prio < SCHED_PRIO_LEVELS; prio++)
+    {
+        list_init(&g_runqueues[prio]);
+        ms = SCHED_SLICE_MAX_MS - (SCHED_SLICE_MAX_MS - SCHED_SLICE_MIN_MS) *
+             prio / (SCHED_PRIO_LEVELS - 1);
+        g_prio_slice[prio] = (ms * HZ + 999) / 1000;
+    }
+    boot = task_alloc(name);
+    KERNEL_ASSERT(boot != NULL, "Cannot allocate the initial task");
+    boot->state = TASK_RUNNING;
+    boot->stack_base = stack_find(stack_get_esp())->base;
+    boot->last_run = rdtsc();
+    this_cpu_write(current, boot);
+    idle = kthread_create("idle", sched_idle, NULL);
+    KERNEL_ASSERT(idle != NULL, "Cannot create the idle task");
+    sched_set_priority(idle, SCHED_PRIO_IDLE);
+}
+
+void sched_enqueue(t_task *task)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    task->state = TASK_READY;
+    runqueue_add(task);
+    if (current_task() != NULL && task_preempts(task, current_task()))
+    {
+        this_cpu_write(need_resched, 1);
+    }
+    irq_restore(flags);
+}
+
+void sched_dequeue(t_task *task)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    runqueue_del(task);
+    irq_restore(flags);
+}
+
+void sched_set_priority(t_task *task, uint32_t prio)
+{
+    t_task      *curr;
+    uint32_t    flags;
+
+    if (prio >= SCHED_PRIO_LEVELS)
+    {
+        prio = SCHED_PRIO_LEVELS - 1;
+    }
+    flags = irq_save();
+    if (task->state == TASK_READY)
+    {
+        runqueue_del(task);
+        task->prio = prio;
+        runqueue_add(task);
+    }
+    else
+    {
+        task->prio = prio;
+    }
+    task->slice = g_prio_slice[prio];
+    curr = current_task();
+    if ((g_prio_bitmap & prio_mask(curr->prio)) != 0 &&
+        (task == curr || prio < curr->prio))
+    {
+        this_cpu_write(need_resched, 1);
+    }
+    irq_restore(flags);
+}
+
+void sched_block(void)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    current_task()->state = TASK_BLOCKED;
+    schedule();
+    irq_restore(flags);
+}
+
+void sched_wakeup(t_task *task)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    if (task->state != TASK_BLOCKED)
+    {
+        irq_restore(flags);
+        return;
+    }
+    if (task->policy == SCHED_DEADLINE && task->dl_throttled)
+    {
+        task->dl_wakeup_pending = TRUE;
+    }
+    else
+    {
+        if (task->policy == SCHED_DEADLINE)
+        {
+            dl_activate(task, ktime_ns());
+        }
+        sched_enqueue(task);
+    }
+    irq_restore(flags);
+}
+
+uint32_t sched_switch_count(void)
+{
+    return (g_switches);
+}
+
+void schedule_tail(void)
+{
+    t_task  *dead;
+
+    dead = g_task_dead;
+    if (dead == NULL || dead == current_task())
+    {
+        return;
+    }
+    g_task_dead = NULL;
+    dl_release(dead);
+    stack_free(dead->stack_base);
+    dead->state = TASK_UNUSED;
+}
+
+void schedule(void)
+{
+    t_task      *prev;
+    t_task      *next;
+    uint32_t    flags;
+    uint64_t    now;
+    uint64_t    now_ns;
+
+    flags = irq_save();
+    KERNEL_ASSERT(!sched_atomic(), "schedule() called in atomic context");
+    prev = current_task();
+    this_cpu_write(need_resched, 0);
+    now_ns = 0;
+    if (prev->policy == SCHED_DEADLINE || dl_has_ready())
+    {
+        now_ns = ktime_ns();
+    }
+    if (prev->policy == SCHED_DEADLINE)
+    {
+        dl_put_prev(prev, now_ns);
+    }
+    if (prev->state == TASK_RUNNING)
+    {
+        if (prev->policy != SCHED_DEADLINE && !dl_has_ready() &&
+            (g_prio_bitmap & prio_mask(prev->prio)) == 0)
+        {
+            prev->slice = g_prio_slice[prev->prio];
+            irq_restore(flags);
+            return;
+        }
+        prev->state = TASK_READY;
+        runqueue_add(prev);
+    }
+    KERNEL_ASSERT(g_prio_bitmap != 0 || dl_has_ready(), "No runnable task");
+    next = runqueue_pick();
+    runqueue_del(next);
+    next->state = TASK_RUNNING;
+    next->slice = g_prio_slice[next->prio];
+    if (next->policy == SCHED_DEADLINE)
+    {
+        next->dl_exec_start = now_ns;
+    }
+    if (next != prev)
+    {
+        now = rdtsc();
+        prev->runtime += now - prev->last_run;
+        next->last_run = now;
+        next->switches++;
+        g_switches++;
+        this_cpu_write(current, next);
+        switch_to(&prev->esp, next->esp);
+        schedule_tail();
+    }
+    irq_restore(flags);
+}
+
+void NORETURN sched_exit(void)
+{
+    t_task  *task;
+
+    irq_save();
+    task = current_task();
+    KERNEL_ASSERT(task->pid != 0, "The initial task cannot exit");
+    task->state = TASK_DEAD;
+    g_task_dead = task;
+    schedule();
+    KERNEL_PANIC("Dead task was scheduled");
+}
+
+void preempt_schedule_irq(void)
+{
+    if (sched_atomic() || current_task()->prio == SCHED_PRIO_IDLE)
+    {
+        return;
+    }
+    schedule();
+}
+
+void sched_tick(void)
+{
+    t_task  *curr;
+
+    curr = current_task();
+    if (curr == NULL)
+    {
+        return;
+    }
+    if (curr->policy == SCHED_DEADLINE)
+    {
+        dl_charge(curr, ktime_ns());
+        if (curr->dl_throttled)
+        {
+            this_cpu_write(need_resched, 1);
+        }
+        return;
+    }
+    if (curr->slice > 0)
+    {
+        curr->slice--;
+    }
+    if (curr->slice == 0 && (g_prio_bitmap & prio_mask(curr->prio)) != 0)
+    {
+        this_cpu_write(need_resched, 1);
+    }
+}
+
+void preempt_disable(void)
+{
+    this_cpu_inc(preempt_count);
+}
+
+void preempt_enable(void)
+{
+    KERNEL_ASSERT(this_cpu_read(preempt_count) != 0,
+                  "Unbalanced preempt_enable");
+    this_cpu_dec(preempt_count);
+    if (this_cpu_read(need_resched) != 0 && !sched_atomic())
+    {
+        schedule();
+    }
+}
+
+static void sched_print_task(const t_task *task, uint64_t now)
+{
+    uint64_t    runtime;
+    uint32_t    ms;
+
+    runtime = task->runtime;
+    if (task->state == TASK_RUNNING)
+    {
+        runtime += now - task->last_run;
+    }
+    ms = (uint32_t)k_udivmod64(cycles_to_ns(runtime), NSEC_PER_MSEC, NULL);
+    printk("  %u  %s  ", task->pid, task_state_name(task->state));
+    if (task->policy == SCHED_DEADLINE)
+    {
+        printk("edf %u/%u us  misses %u/%u",
+               (uint32_t)k_udivmod64(task->dl_runtime, NSEC_PER_USEC, NULL),
+               (uint32_t)k_udivmod64(task->dl_period, NSEC_PER_USEC, NULL),
+               task->dl_misses, task->dl_jobs);
+    }
+    else
+    {
+        printk("prio %u  slice %u/%u", task->prio, task->slice,
+               g_prio_slice[task->prio]);
+    }
+    printk("  cpu %u ms  switches %u  %s\n", ms, task->switches, task->name);
+}
+
+void sched_print_tasks(void)
+{
+    t_task      snapshot[TASK_MAX];
+    uint32_t    flags;
+    uint32_t    count;
+    uint32_t    i;
+    uint64_t    now;
+
+    flags = irq_save();
+    now = rdtsc();
+    count = 0;
+    for (i = 0; i < TASK_MAX; i++)
+    {
+        if (g_tasks[i].state != TASK_UNUSED)
+        {
+            snapshot[count++] = g_tasks[i];
+        }
+    }
+    irq_restore(flags);
+    printk("\n=== Tasks (%u, %u context switches) ===\n", count, g_switches);
+    for (i = 0; i < count; i++)
+    {
+        sched_print_task(&snapshot[i], now);
+    }
+    printk("  ready bitmap 0x%x, EDF bandwidth %u%%\n\n", g_prio_bitmap,
+           (sched_dl_bandwidth() * 100) >> SCHED_DL_BW_SHIFT);
+}
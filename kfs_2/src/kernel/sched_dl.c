@@ -0,0 +1,342 @@
+#include "kernel.h"
+#include "../include/sched.h"
+#include "../include/kthread.h"
+#include "../include/wait.h"
+#include "../include/cpu.h"
+#include "../include/tick.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
+
+static t_list               g_dl_queue = LIST_INIT(g_dl_queue);
+static uint32_t             g_dl_total_bw;
+
+static volatile bool_t      g_dl_bench_stop;
+static t_wait_queue         g_dl_bench_wait = WAIT_QUEUE_INIT(g_dl_bench_wait);
+static uint64_t             g_dl_bench_max_lateness;
+static uint64_t             g_dl_bench_total_lateness;
+static uint32_t             g_dl_bench_jobs;
+static uint32_t             g_dl_bench_misses;
+
+void dl_enqueue(t_task *task)
+{
+    t_list  *pos;
+
+    pos = g_dl_queue.next;
+    while (pos != &g_dl_queue &&
+           LIST_ENTRY(pos, t_task, run_node)->dl_abs_deadline <=
+           task->dl_abs_deadline)
+    {
+        pos = pos->next;
+    }
+    list_add_tail(&task->run_node, pos);
+}
+
+void dl_dequeue(t_task *task)
+{
+    list_del(&task->run_node);
+}
+
+t_task *dl_pick(void)
+{
+    if (list_empty(&g_dl_queue))
+    {
+        return (NULL);
+    }
+    return (LIST_ENTRY(g_dl_queue.next, t_task, run_node));
+}
+
+bool_t dl_has_ready(void)
+{
+    return ((bool_t)!list_empty(&g_dl_queue));
+}
+
+uint32_t sched_dl_bandwidth(void)
+{
+    return (g_dl_total_bw);
+}
+
+static uint64_t dl_ns_to_jiffies(uint64_t ns)
+{
+    uint32_t    rem;
+    uint64_t    ticks;
+
+    ticks = k_udivmod64(ns, TICK_NSEC, &rem);
+    return (rem != 0 ? ticks + 1 : ticks);
+}
+
+static void dl_replenish_timer(void *data)
+{
+    t_task      *task;
+    uint32_t    flags;
+    uint64_t    now;
+
+    task = (t_task *)data;
+    flags = irq_save();
+    if (!task->dl_throttled)
+    {
+        irq_restore(flags);
+        return;
+    }
+    now = ktime_ns();
+    if (task->dl_overrun)
+    {
+        task->dl_misses++;
+    }
+    task->dl_overrun = FALSE;
+    task->dl_throttled = FALSE;
+    task->dl_abs_deadline += task->dl_period;
+    if (task->dl_abs_deadline <= now)
+    {
+        task->dl_abs_deadline = now + task->dl_deadline;
+    }
+    task->dl_budget = task->dl_runtime;
+    if (task->dl_wakeup_pending)
+    {
+        task->dl_wakeup_pending = FALSE;
+        sched_enqueue(task);
+    }
+    irq_restore(flags);
+}
+
+void dl_charge(t_task *task, uint64_t now)
+{
+    uint64_t    delta;
+
+    delta = now - task->dl_exec_start;
+    task->dl_exec_start = now;
+    if (delta < task->dl_budget)
+    {
+        task->dl_budget -= delta;
+        return;
+    }
+    task->dl_budget = 0;
+    if (!task->dl_throttled)
+    {
+        task->dl_throttled = TRUE;
+        task->dl_overrun = TRUE;
+        task->dl_release = task->dl_abs_deadline;
+    }
+}
+
+static void dl_job_done(t_task *task, uint64_t now)
+{
+    task->dl_jobs++;
+    task->dl_overrun = FALSE;
+    if (now > task->dl_abs_deadline)
+    {
+        task->dl_misses++;
+    }
+}
+
+void dl_put_prev(t_task *task, uint64_t now)
+{
+    dl_charge(task, now);
+    if (task->dl_throttled && task->state != TASK_DEAD)
+    {
+        task->dl_wakeup_pending = (bool_t)(task->state == TASK_RUNNING);
+        task->state = TASK_BLOCKED;
+        mod_timer(&task->dl_timer, jiffies_get() +
+                  (task->dl_release > now ?
+                   dl_ns_to_jiffies(task->dl_release - now) : 0));
+    }
+    else if (task->state == TASK_BLOCKED)
+    {
+        dl_job_done(task, now);
+    }
+}
+
+void dl_activate(t_task *task, uint64_t now)
+{
+    if (now >= task->dl_abs_deadline ||
+        task->dl_budget * task->dl_period >
+        task->dl_runtime * (task->dl_abs_deadline - now))
+    {
+        task->dl_abs_deadline = now + task->dl_deadline;
+        task->dl_budget = task->dl_runtime;
+    }
+}
+
+void dl_release(t_task *task)
+{
+    if (task->policy != SCHED_DEADLINE)
+    {
+        return;
+    }
+    del_timer(&task->dl_timer);
+    g_dl_total_bw -= task->dl_bw;
+    task->policy = SCHED_NORMAL;
+}
+
+int sched_setattr_dl(t_task *task, uint64_t runtime_ns,
+                     uint64_t deadline_ns, uint64_t period_ns)
+{
+    uint32_t    bw;
+    uint32_t    flags;
+    uint64_t    now;
+    bool_t      was_ready;
+
+    if (runtime_ns == 0 || runtime_ns > deadline_ns ||
+        deadline_ns > period_ns || period_ns > SCHED_DL_MAX_PERIOD_NS)
+    {
+        return (-1);
+    }
+    bw = (uint32_t)k_udivmod64(runtime_ns << SCHED_DL_BW_SHIFT,
+                               (uint32_t)period_ns, NULL);
+    flags = irq_save();
+    if (g_dl_total_bw - (task->policy == SCHED_DEADLINE ? task->dl_bw : 0) +
+        bw > SCHED_DL_BW_LIMIT)
+    {
+        irq_restore(flags);
+        return (-1);
+    }
+    was_ready = (bool_t)(task->state == TASK_READY);
+    if (was_ready)
+    {
+        sched_dequeue(task);
+    }
+    if (task->policy == SCHED_DEADLINE)
+    {
+        g_dl_total_bw -= task->dl_bw;
+    }
+    else
+    {
+        timer_setup(&task->dl_timer, dl_replenish_timer, task);
+    }
+    now = ktime_ns();
+    g_dl_total_bw += bw;
+    task->policy = SCHED_DEADLINE;
+    task->dl_bw = bw;
+    task->dl_runtime = runtime_ns;
+    task->dl_deadline = deadline_ns;
+    task->dl_period = period_ns;
+    task->dl_abs_deadline = now + deadline_ns;
+    task->dl_budget = runtime_ns;
+    task->dl_exec_start = now;
+    if (was_ready)
+    {
+        sched_enqueue(task);
+    }
+    else if (task == current_task())
+    {
+        this_cpu_write(need_resched, 1);
+    }
+    irq_restore(flags);
+    return (0);
+}
+
+void sched_dl_yield(void)
+{
+    t_task      *task;
+    uint32_t    flags;
+    uint64_t    now;
+
+    task = current_task();
+    if (task->policy != SCHED_DEADLINE)
+    {
+        kthread_yield();
+        return;
+    }
+    flags = irq_save();
+    now = ktime_ns();
+    dl_charge(task, now);
+    if (!task->dl_throttled)
+    {
+        dl_job_done(task, now);
+        task->dl_release = task->dl_abs_deadline - task->dl_deadline +
+                           task->dl_period;
+        if (task->dl_release > now)
+        {
+            task->dl_throttled = TRUE;
+        }
+        else
+        {
+            task->dl_abs_deadline = now + task->dl_deadline;
+            task->dl_budget = task->dl_runtime;
+        }
+    }
+    schedule();
+    irq_restore(flags);
+}
+
+static void dl_bench_hog(void *arg)
+{
+    (void)arg;
+
+    while (!g_dl_bench_stop)
+    {
+        __asm__ volatile ("pause");
+    }
+}
+
+static void dl_bench_job(void *arg)
+{
+    t_task      *self;
+    uint64_t    start;
+    uint64_t    release;
+    uint64_t    lateness;
+    uint32_t    jobs;
+
+    jobs = (uint32_t)arg;
+    self = current_task();
+    while (!g_dl_bench_stop && self->dl_jobs < jobs)
+    {
+        start = ktime_ns();
+        release = self->dl_abs_deadline - self->dl_deadline;
+        lateness = start > release ? start - release : 0;
+        g_dl_bench_total_lateness += lateness;
+        if (lateness > g_dl_bench_max_lateness)
+        {
+            g_dl_bench_max_lateness = lateness;
+        }
+        while (ktime_ns() - start < DL_BENCH_WORK_NS)
+        {
+        }
+        sched_dl_yield();
+    }
+    g_dl_bench_jobs = self->dl_jobs;
+    g_dl_bench_misses = self->dl_misses;
+    g_dl_bench_stop = TRUE;
+    wake_up(&g_dl_bench_wait);
+}
+
+void dl_benchmark(uint32_t jobs)
+{
+    t_task      *task;
+
+    g_dl_bench_stop = FALSE;
+    g_dl_bench_jobs = 0;
+    g_dl_bench_misses = 0;
+    g_dl_bench_max_lateness = 0;
+    g_dl_bench_total_lateness = 0;
+    if (kthread_create("dlhog", dl_bench_hog, NULL) == NULL)
+    {
+        printk("dlbench: cannot create threads\n");
+        return;
+    }
+    task = kthread_create("dljob", dl_bench_job, (void *)jobs);
+    if (task == NULL)
+    {
+        g_dl_bench_stop = TRUE;
+        printk("dlbench: cannot create threads\n");
+        return;
+    }
+    if (sched_setattr_dl(task, DL_BENCH_RUNTIME_NS, DL_BENCH_PERIOD_NS,
+                         DL_BENCH_PERIOD_NS) != 0)
+    {
+        g_dl_bench_stop = TRUE;
+        printk("dlbench: admission control rejected the reservation\n");
+        return;
+    }
+    wait_event(&g_dl_bench_wait, g_dl_bench_stop);
+    printk("EDF job: runtime %llu us, period %llu us, %u jobs against a CPU hog\n",
+           k_udivmod64(DL_BENCH_RUNTIME_NS, NSEC_PER_USEC, NULL),
+           k_udivmod64(DL_BENCH_PERIOD_NS, NSEC_PER_USEC, NULL),
+           g_dl_bench_jobs);
+    printk("  release lateness: avg %llu us, max %llu us\n",
+           k_udivmod64(k_udivmod64(g_dl_bench_total_lateness,
+                                   g_dl_bench_jobs != 0 ? g_dl_bench_jobs : 1,
+                                   NULL),
+                       NSEC_PER_USEC, NULL),
+           k_udivmod64(g_dl_bench_max_lateness, NSEC_PER_USEC, NULL));
+    printk("  deadline misses: %u\n", g_dl_bench_misses);
+}
@@ -4,6 +4,23 @@
 #include "keyboard.h"
 #include "vtty.h"
 #include "vga.h"
+#include "pmm.h"
+#include "paging.h"
+#include "irqstat.h"
+#include "softirq.h"
+#include "irqchip.h"
+#include "acpi.h"
+#include "idt.h"
+#include "time.h"
+#include "ktime.h"
+#include "tick.h"
+#include "hpet.h"
+#include "apic.h"
+#include "timer.h"
+#include "kthread.h"
+#include "smp.h"
+#include "workq.h"
+#include "spinlock.h"
 #include "types.h"
 
 extern size_t   k_strlen(const char *s);
@@ -11,6 +28,7 @@ extern int      k_strcmp(const char *s1, const char *s2);
 extern int      k_strncmp(const char *s1, const char *s2, size_t n);
 extern char     *k_strcpy(char *dest, const char *src);
 extern void     *k_memset(void *s, int c, size_t n);
+extern int      k_atou(const char *str, uint32_t *value);
 
 extern void printk(const char *fmt, ...);
 
@@ -23,8 +41,24 @@ static char     *g_argv[SHELL_MAX_ARGS];
 static const t_shell_cmd g_commands[] = {
     {"help",    "Display this help message",            cmd_help},
     {"stack",   "Print kernel stack dump",              cmd_stack},
+    {"stackuse", "Show peak usage of each stack",      cmd_stackuse},
     {"gdt",     "Display GDT entries",                  cmd_gdt},
     {"regs",    "Display CPU registers",                cmd_regs},
+    {"mem",     "Display physical memory and paging",   cmd_mem},
+    {"irqstat", "Interrupt counts/latency [vec|reset]",  cmd_irqstat},
+    {"acpi",    "Display ACPI tables, CPUs and IOAPICs", cmd_acpi},
+    {"intbench", "Compare legacy vs streamlined int stubs", cmd_intbench},
+    {"uptime",  "Time since boot",                      cmd_uptime},
+    {"idlestat", "Tickless idle wakeups and residency",  cmd_idlestat},
+    {"timerbench", "Timer wheel add/mod/del cost [n]",   cmd_timerbench},
+    {"ctxbench", "Kernel thread context switch cost [n]", cmd_ctxbench},
+    {"ps",      "List tasks with state, priority and CPU time", cmd_ps},
+    {"dlbench", "EDF job deadline misses under load [n]", cmd_dlbench},
+    {"kbdlat",  "Keyboard IRQ to shell wakeup latency [reset]", cmd_kbdlat},
+    {"cpus",    "List online CPUs, TSS and AP round trip", cmd_cpus},
+    {"parbench", "Work-stealing scaling over all CPUs [n]", cmd_parbench},
+    {"lockstat", "Lock contention and hold times [reset]", cmd_lockstat},
+    {"ipibench", "IPI and remote call round trip [n]", cmd_ipibench},
     {"clear",   "Clear the screen",                     cmd_clear},
     {"info",    "Display kernel information",           cmd_info},
     {"reboot",  "Reboot the system",                    cmd_reboot},
@@ -96,7 +130,7 @@ static const t_shell_cmd *find_command(const char *name)
     return NULL;
 }
 
-void    shell_init(void)
+void    __init shell_init(void)
 {
     k_memset(g_cmd_buffer, 0, SHELL_CMD_MAX_LEN);
     g_cmd_pos = 0;
@@ -189,29 +223,24 @@ void    shell_run(void)
     while (1)
     {
 
-        if (keyboard_has_key())
-        {
-            event = keyboard_get_key();
+        keyboard_wait();
+        event = keyboard_get_key();
 
 
-            if (event.pressed)
-            {
+        if (event.pressed)
+        {
 
-                if (keyboard_alt_pressed() &&
-                    event.scancode >= KEY_F1 && event.scancode <= KEY_F8)
-                {
-                    vtty_switch((uint8_t)(event.scancode - KEY_F1));
-                }
+            if (keyboard_alt_pressed() &&
+                event.scancode >= KEY_F1 && event.scancode <= KEY_F8)
+            {
+                vtty_switch((uint8_t)(event.scancode - KEY_F1));
+            }
 
-                else if (event.ascii != 0)
-                {
-                    shell_input(event.ascii);
-                }
+            else if (event.ascii != 0)
+            {
+                shell_input(event.ascii);
             }
         }
-
-
-        __asm__ __volatile__("hlt");
     }
 }
 
@@ -243,6 +272,15 @@ int     cmd_stack(int argc, char **argv)
     return 0;
 }
 
+int     cmd_stackuse(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    stack_print_usage();
+    return 0;
+}
+
 int     cmd_gdt(int argc, char **argv)
 {
     (void)argc;
@@ -261,6 +299,195 @@ int     cmd_regs(int argc, char **argv)
     return 0;
 }
 
+int     cmd_mem(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    pmm_print();
+    paging_print();
+    return 0;
+}
+
+int     cmd_irqstat(int argc, char **argv)
+{
+    uint32_t    vector;
+
+    if (argc < 2)
+    {
+        irqstat_print();
+        return 0;
+    }
+    if (k_strcmp(argv[1], "reset") == 0)
+    {
+        irqstat_reset();
+        printk("Interrupt statistics cleared\n");
+        return 0;
+    }
+    if (k_atou(argv[1], &vector) != 0 || vector > 255)
+    {
+        printk("Usage: irqstat [vector|reset]\n");
+        return 1;
+    }
+    irqstat_print_vector((uint8_t)vector);
+    return 0;
+}
+
+int     cmd_acpi(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    acpi_print();
+    return 0;
+}
+
+int     cmd_intbench(int argc, char **argv)
+{
+    uint32_t    iterations;
+
+    iterations = INT_BENCH_DEFAULT_ITERS;
+    if (argc >= 2 && (k_atou(argv[1], &iterations) != 0 || iterations == 0))
+    {
+        printk("Usage: intbench [iterations]\n");
+        return 1;
+    }
+    int_benchmark(iterations);
+    return 0;
+}
+
+int     cmd_uptime(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    time_print_uptime();
+    return 0;
+}
+
+int     cmd_idlestat(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    idle_print_stats();
+    return 0;
+}
+
+int     cmd_timerbench(int argc, char **argv)
+{
+    uint32_t    count;
+
+    count = TIMER_BENCH_DEFAULT;
+    if (argc >= 2 && (k_atou(argv[1], &count) != 0 || count == 0))
+    {
+        printk("Usage: timerbench [count]\n");
+        return 1;
+    }
+    timer_benchmark(count);
+    return 0;
+}
+
+int     cmd_ctxbench(int argc, char **argv)
+{
+    uint32_t    iterations;
+
+    iterations = KTHREAD_BENCH_DEFAULT_ITERS;
+    if (argc >= 2 && (k_atou(argv[1], &iterations) != 0 || iterations == 0))
+    {
+        printk("Usage: ctxbench [iterations]\n");
+        return 1;
+    }
+    kthread_benchmark(iterations);
+    return 0;
+}
+
+int     cmd_dlbench(int argc, char **argv)
+{
+    uint32_t    jobs;
+
+    jobs = DL_BENCH_DEFAULT_JOBS;
+    if (argc >= 2 && (k_atou(argv[1], &jobs) != 0 || jobs == 0))
+    {
+        printk("Usage: dlbench [jobs]\n");
+        return 1;
+    }
+    dl_benchmark(jobs);
+    return 0;
+}
+
+int     cmd_kbdlat(int argc, char **argv)
+{
+    if (argc >= 2 && k_strcmp(argv[1], "reset") == 0)
+    {
+        keyboard_reset_latency();
+        printk("Keyboard latency statistics cleared\n");
+        return 0;
+    }
+    keyboard_print_latency();
+    return 0;
+}
+
+int     cmd_ps(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    sched_print_tasks();
+    return 0;
+}
+
+int     cmd_cpus(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    smp_print();
+    return 0;
+}
+
+int     cmd_parbench(int argc, char **argv)
+{
+    uint32_t    jobs;
+
+    jobs = WORKQ_BENCH_DEFAULT;
+    if (argc >= 2 && (k_atou(argv[1], &jobs) != 0 || jobs == 0 ||
+                      jobs > WORKQ_BENCH_MAX))
+    {
+        printk("Usage: parbench [jobs] (1-%u)\n", WORKQ_BENCH_MAX);
+        return 1;
+    }
+    workq_benchmark(jobs);
+    return 0;
+}
+
+int     cmd_ipibench(int argc, char **argv)
+{
+    uint32_t    iterations;
+
+    iterations = SMP_IPI_BENCH_DEFAULT;
+    if (argc >= 2 && (k_atou(argv[1], &iterations) != 0 || iterations == 0 ||
+                      iterations > SMP_IPI_BENCH_MAX))
+    {
+        printk("Usage: ipibench [calls] (1-%u)\n", SMP_IPI_BENCH_MAX);
+        return 1;
+    }
+    smp_ipi_benchmark(iterations);
+    return 0;
+}
+
+int     cmd_lockstat(int argc, char **argv)
+{
+    if (argc >= 2 && k_strcmp(argv[1], "reset") == 0)
+    {
+        lockstat_reset();
+        printk("Lock statistics cleared\n");
+        return 0;
+    }
+    lockstat_print();
+    return 0;
+}
+
 int     cmd_clear(int argc, char **argv)
 {
     (void)argc;
@@ -272,8 +499,11 @@ int     cmd_clear(int argc, char **argv)
 
 int     cmd_info(int argc, char **argv)
 {
+    const t_tsc_info    *tsc;
+
     (void)argc;
     (void)argv;
+    tsc = tsc_get_info();
 
     printk("\n");
     printk("=== KFS-2 Kernel Information ===\n");
@@ -285,6 +515,31 @@ int     cmd_info(int argc, char **argv)
     printk("  - Custom GDT at 0x800\n");
     printk("  - Kernel & User segments\n");
     printk("  - Stack inspection\n");
+    printk("  - Paging (%s, NX %s)\n", CONFIG_PAE ? "PAE" : "32-bit",
+           paging_nx_enabled() ? "on" : "off");
+    printk("  - Interrupts via %s\n", g_irqchip->name);
+    if (tsc->khz != 0)
+    {
+        printk("  - TSC %u.%u%u%u MHz (%s, calibrated against %s)\n",
+               tsc->khz / 1000, (tsc->khz / 100) % 10, (tsc->khz / 10) % 10,
+               tsc->khz % 10, tsc->invariant ? "invariant" : "not invariant",
+               tsc->reference);
+    }
+    else
+    {
+        printk("  - TSC not available, ktime uses jiffies\n");
+    }
+    printk("  - Tick from %s (%s)\n", tick_clockevent()->name,
+           tick_mode() == CLOCK_EVT_ONESHOT ? "one-shot" : "periodic");
+    if (hpet_available())
+    {
+        printk("  - HPET %u kHz, %u timers\n", hpet_get_info()->freq_khz,
+               hpet_get_info()->timers);
+    }
+    if (lapic_timer_khz() != 0)
+    {
+        printk("  - LAPIC timer %u kHz (divide by 16)\n", lapic_timer_khz());
+    }
     printk("  - PS/2 Keyboard\n");
     printk("  - PS/2 Mouse with scroll\n");
     printk("  - Virtual Terminals\n");
@@ -336,6 +591,7 @@ int     cmd_halt(int argc, char **argv)
     printk("You can safely power off the computer.\n");
 
 
+    smp_stop_others();
     __asm__ __volatile__("cli");
 
     while (1)
@@ -0,0 +1,691 @@
+#include "kernel.h"
+#include "../include/smp.h"
+#include "../include/gdt.h"
+#include "../include/idt.h"
+#include "../include/apic.h"
+#include "../include/acpi.h"
+#include "../include/cpu.h"
+#include "../include/ktime.h"
+#include "../include/paging.h"
+#include "../include/stack.h"
+#include "../include/percpu.h"
+#include "../include/workq.h"
+#include "../include/atomic.h"
+#include "../include/sched.h"
+#include "../lib/math.h"
+
+extern uint8_t      stack_top[];
+
+static t_cpu        g_cpus[SMP_MAX_CPUS];
+static uint32_t     g_cpu_count;
+static uint32_t     g_cpus_online;
+
+static t_smp_callq          g_callq[SMP_MAX_CPUS];
+static volatile uint32_t    g_smp_stopping;
+static volatile uint32_t    g_smp_stopped;
+static volatile uint32_t    g_bench_calls;
+
+static void smp_noop(void *arg)
+{
+    (void)arg;
+}
+
+static void smp_delay_us(uint32_t us)
+{
+    uint64_t    end;
+
+    end = ktime_ns() + (uint64_t)us * NSEC_PER_USEC;
+    while (ktime_ns() < end)
+    {
+        cpu_relax();
+    }
+}
+
+static void ap_halt(t_cpu *cpu)
+{
+    __asm__ volatile ("cli" : : : "memory");
+    cpu->idle = TRUE;
+    smp_mb();
+    if (cpu->work_fn == NULL && !workq_has_work())
+    {
+        __asm__ volatile ("sti; hlt" : : : "memory");
+    }
+    else
+    {
+        __asm__ volatile ("sti" : : : "memory");
+    }
+    cpu->idle = FALSE;
+}
+
+static void NORETURN ap_idle(t_cpu *cpu)
+{
+    t_smp_fn    fn;
+
+    while (1)
+    {
+        fn = cpu->work_fn;
+        if (fn == NULL)
+        {
+            if (!workq_run_one())
+            {
+                ap_halt(cpu);
+            }
+            continue;
+        }
+        if ((uint32_t)fn == SMP_WORK_CLAIMED)
+        {
+            cpu_relax();
+            continue;
+        }
+        fn(cpu->work_arg);
+        cpu->jobs++;
+        barrier();
+        cpu->work_fn = NULL;
+    }
+}
+
+static void smp_kick(const t_cpu *cpu)
+{
+    if (cpu->idle)
+    {
+        lapic_send_vector(cpu->apic_id, SMP_IPI_RESCHED_VECTOR);
+    }
+}
+
+static void NORETURN ap_main(uint32_t id)
+{
+    t_cpu   *cpu;
+
+    cpu = &g_cpus[id];
+    gdt_reload();
+    percpu_init(id);
+    this_cpu_write(irq_stack_top, cpu->irq_stack + IRQ_STACK_SIZE);
+    idt_load();
+    lapic_setup();
+    gdt_load_tss(id, &cpu->tss, cpu->stack + SMP_STACK_SIZE);
+    barrier();
+    cpu->online = TRUE;
+    __asm__ volatile ("sti");
+    ap_idle(cpu);
+}
+
+static void smp_call_drain(t_smp_callq *q)
+{
+    t_smp_call  call;
+    uint32_t    flags;
+
+    while (1)
+    {
+        flags = spin_lock_irqsave(&q->lock);
+        if (q->head == q->tail)
+        {
+            spin_unlock_irqrestore(&q->lock, flags);
+            return;
+        }
+        call = q->calls[q->head & SMP_CALL_QUEUE_MASK];
+        q->head++;
+        q->run++;
+        spin_unlock_irqrestore(&q->lock, flags);
+        call.fn(call.arg);
+        if (call.pending != NULL)
+        {
+            atomic_dec(call.pending);
+        }
+    }
+}
+
+static void smp_call_poll(void)
+{
+    smp_call_drain(&g_callq[smp_processor_id()]);
+}
+
+static int smp_call_ipi(t_regs *regs, void *ctx)
+{
+    t_smp_callq *q;
+
+    (void)regs;
+    (void)ctx;
+    q = &g_callq[smp_processor_id()];
+    q->ipis++;
+    smp_call_drain(q);
+    return (IRQ_HANDLED);
+}
+
+static int smp_resched_ipi(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+    if (current_task() != NULL)
+    {
+        this_cpu_write(need_resched, 1);
+    }
+    return (IRQ_HANDLED);
+}
+
+static void NORETURN smp_stop_self(void)
+{
+    t_cpu   *cpu;
+
+    __asm__ volatile ("cli");
+    cpu = &g_cpus[smp_processor_id()];
+    if (!cpu->stopped)
+    {
+        cpu->stopped = TRUE;
+        atomic_inc(&g_smp_stopped);
+    }
+    while (1)
+    {
+        __asm__ volatile ("hlt");
+    }
+}
+
+static int smp_nmi_stop(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+    if (g_smp_stopping == 0)
+    {
+        return (IRQ_NONE);
+    }
+    smp_stop_self();
+}
+
+static t_trampoline *smp_trampoline(void)
+{
+    return ((t_trampoline *)(SMP_TRAMPOLINE_BASE +
+                             (uint32_t)(trampoline_params - trampoline_start)));
+}
+
+static int __init smp_boot_ap(t_cpu *cpu)
+{
+    volatile t_trampoline   *params;
+    uint64_t                start;
+    uint64_t                deadline;
+    uint32_t                i;
+
+    cpu->stack = stack_alloc(cpu->name, SMP_STACK_SIZE);
+    cpu->irq_stack = stack_alloc(cpu->irq_name, IRQ_STACK_SIZE);
+    if (cpu->stack == 0 || cpu->irq_stack == 0)
+    {
+        return (-1);
+    }
+    params = smp_trampoline();
+    params->stack = cpu->stack + SMP_STACK_SIZE;
+    params->cpu = cpu->id;
+    barrier();
+
+    start = ktime_cycles();
+    lapic_send_init(cpu->apic_id);
+    smp_delay_us(SMP_INIT_DELAY_US);
+    for (i = 0; i < 2 && !cpu->online; i++)
+    {
+        lapic_send_sipi(cpu->apic_id,
+                        (uint8_t)(SMP_TRAMPOLINE_BASE >> PAGE_SHIFT));
+        smp_delay_us(SMP_SIPI_DELAY_US);
+    }
+    deadline = ktime_ns() + (uint64_t)SMP_BOOT_TIMEOUT_US * NSEC_PER_USEC;
+    while (!cpu->online && ktime_ns() < deadline)
+    {
+        cpu_relax();
+    }
+    if (!cpu->online)
+    {
+        return (-1);
+    }
+    cpu->boot_cycles = ktime_cycles() - start;
+    return (0);
+}
+
+static void __init smp_add_cpu(uint8_t apic_id, uint8_t acpi_id)
+{
+    t_cpu   *cpu;
+
+    cpu = &g_cpus[g_cpu_count];
+    cpu->id = g_cpu_count;
+    cpu->apic_id = apic_id;
+    cpu->acpi_id = acpi_id;
+    k_strcpy(cpu->name, "cpu");
+    k_utoa(cpu->id, cpu->name + 3, 10);
+    k_strcpy(cpu->irq_name, "irq");
+    k_utoa(cpu->id, cpu->irq_name + 3, 10);
+    spin_lock_init(&g_callq[cpu->id].lock, "smp_call");
+    g_cpu_count++;
+}
+
+void __init smp_init(void)
+{
+    const t_acpi_info   *acpi;
+    t_trampoline        *params;
+    uint8_t             bsp;
+    uint32_t            i;
+
+    acpi = acpi_get_info();
+    bsp = apic_enabled() ? lapic_id() : 0;
+    smp_add_cpu(bsp, 0);
+    g_cpus[0].online = TRUE;
+    g_cpus_online = 1;
+    gdt_load_tss(0, &g_cpus[0].tss, (uint32_t)stack_top);
+    if (!apic_enabled() || !acpi->has_madt || !tsc_get_info()->present)
+    {
+        return;
+    }
+    int_register(SMP_IPI_CALL_VECTOR, smp_call_ipi, NULL);
+    int_register(SMP_IPI_RESCHED_VECTOR, smp_resched_ipi, NULL);
+    exception_register(SMP_NMI_VECTOR, smp_nmi_stop, NULL);
+
+    for (i = 0; i < acpi->cpu_count && g_cpu_count < SMP_MAX_CPUS; i++)
+    {
+        if (acpi->cpus[i].apic_id == bsp)
+        {
+            g_cpus[0].acpi_id = acpi->cpus[i].acpi_id;
+        }
+        else if (acpi->cpus[i].enabled)
+        {
+            smp_add_cpu(acpi->cpus[i].apic_id, acpi->cpus[i].acpi_id);
+        }
+    }
+    if (g_cpu_count == 1)
+    {
+        return;
+    }
+
+    k_memcpy((void *)SMP_TRAMPOLINE_BASE, trampoline_start,
+             (size_t)(trampoline_end - trampoline_start));
+    params = smp_trampoline();
+    params->cr3 = read_cr3();
+    params->cr4 = read_cr4();
+    params->cr0 = read_cr0();
+    params->efer_nx = paging_nx_enabled() ? 1 : 0;
+    params->entry = (uint32_t)ap_main;
+    for (i = 1; i < g_cpu_count; i++)
+    {
+        if (smp_boot_ap(&g_cpus[i]) != 0)
+        {
+            printk("SMP: cpu %u (APIC %u) did not come online\n",
+                   i, g_cpus[i].apic_id);
+            break;
+        }
+        g_cpus_online++;
+    }
+    printk("SMP: %u of %u CPUs online\n", g_cpus_online, g_cpu_count);
+}
+
+uint32_t smp_cpu_count(void)
+{
+    return (g_cpu_count);
+}
+
+uint32_t smp_online_count(void)
+{
+    return (g_cpus_online);
+}
+
+uint32_t smp_processor_id(void)
+{
+    return (this_cpu_read(cpu));
+}
+
+const t_cpu *smp_get_cpu(uint32_t cpu)
+{
+    if (cpu >= g_cpu_count)
+    {
+        return (NULL);
+    }
+    return (&g_cpus[cpu]);
+}
+
+int smp_run_on(uint32_t cpu, t_smp_fn fn, void *arg)
+{
+    t_cpu   *target;
+
+    if (cpu >= g_cpu_count || fn == NULL || !g_cpus[cpu].online)
+    {
+        return (-1);
+    }
+    target = &g_cpus[cpu];
+    if (cpu == smp_processor_id())
+    {
+        fn(arg);
+        target->jobs++;
+        return (0);
+    }
+    if (atomic_cmpxchg((volatile uint32_t *)&target->work_fn, 0,
+                       SMP_WORK_CLAIMED) != 0)
+    {
+        return (-1);
+    }
+    target->work_arg = arg;
+    barrier();
+    target->work_fn = fn;
+    smp_mb();
+    smp_kick(target);
+    return (0);
+}
+
+void smp_wait(uint32_t cpu)
+{
+    if (cpu >= g_cpu_count)
+    {
+        return;
+    }
+    while (g_cpus[cpu].work_fn != NULL)
+    {
+        cpu_relax();
+    }
+}
+
+static bool_t smp_call_queue(uint32_t cpu, t_smp_fn fn, void *arg,
+                             volatile uint32_t *pending)
+{
+    t_smp_callq *q;
+    t_smp_call  *call;
+    uint32_t    flags;
+    bool_t      kick;
+
+    q = &g_callq[cpu];
+    flags = spin_lock_irqsave(&q->lock);
+    while (q->tail - q->head >= SMP_CALL_QUEUE_SIZE)
+    {
+        spin_unlock_irqrestore(&q->lock, flags);
+        smp_call_poll();
+        cpu_relax();
+        flags = spin_lock_irqsave(&q->lock);
+    }
+    call = &q->calls[q->tail & SMP_CALL_QUEUE_MASK];
+    call->fn = fn;
+    call->arg = arg;
+    call->pending = pending;
+    kick = (bool_t)(q->head == q->tail);
+    q->tail++;
+    q->queued++;
+    if (kick)
+    {
+        q->kicks++;
+    }
+    spin_unlock_irqrestore(&q->lock, flags);
+    return (kick);
+}
+
+static void smp_send_call_ipis(t_cpumask kick, uint32_t self)
+{
+    t_cpumask   others;
+    uint32_t    i;
+
+    if (kick == 0)
+    {
+        return;
+    }
+    others = (SMP_CPU(g_cpu_count) - 1) & ~SMP_CPU(self);
+    if (kick == others && g_cpus_online == g_cpu_count)
+    {
+        lapic_send_vector_others(SMP_IPI_CALL_VECTOR);
+        return;
+    }
+    for (i = 0; i < g_cpu_count; i++)
+    {
+        if ((kick & SMP_CPU(i)) != 0)
+        {
+            lapic_send_vector(g_cpus[i].apic_id, SMP_IPI_CALL_VECTOR);
+        }
+    }
+}
+
+int smp_call_function(t_cpumask mask, t_smp_fn fn, void *arg, bool_t wait)
+{
+    volatile uint32_t   pending;
+    t_cpumask           kick;
+    uint32_t            self;
+    uint32_t            flags;
+    uint32_t            i;
+
+    if (fn == NULL)
+    {
+        return (-1);
+    }
+    self = smp_processor_id();
+    pending = 0;
+    kick = 0;
+    for (i = 0; i < g_cpu_count; i++)
+    {
+        if (i == self || (mask & SMP_CPU(i)) == 0 || !g_cpus[i].online)
+        {
+            continue;
+        }
+        if (wait)
+        {
+            atomic_inc(&pending);
+        }
+        if (smp_call_queue(i, fn, arg, wait ? &pending : NULL))
+        {
+            kick |= SMP_CPU(i);
+        }
+    }
+    smp_send_call_ipis(kick, self);
+    if ((mask & SMP_CPU(self)) != 0)
+    {
+        flags = irq_save();
+        fn(arg);
+        irq_restore(flags);
+    }
+    while (pending != 0)
+    {
+        smp_call_poll();
+        cpu_relax();
+    }
+    return (0);
+}
+
+void smp_send_reschedule(uint32_t cpu)
+{
+    if (cpu >= g_cpu_count || !g_cpus[cpu].online)
+    {
+        return;
+    }
+    if (cpu != smp_processor_id())
+    {
+        lapic_send_vector(g_cpus[cpu].apic_id, SMP_IPI_RESCHED_VECTOR);
+    }
+    else if (current_task() != NULL)
+    {
+        this_cpu_write(need_resched, 1);
+    }
+}
+
+void smp_kick_idle(void)
+{
+    uint32_t    self;
+    uint32_t    i;
+
+    self = smp_processor_id();
+    smp_mb();
+    for (i = 0; i < g_cpu_count; i++)
+    {
+        if (i != self && g_cpus[i].online)
+        {
+            smp_kick(&g_cpus[i]);
+        }
+    }
+}
+
+void smp_stop_others(void)
+{
+    uint64_t    deadline;
+
+    if (atomic_cmpxchg(&g_smp_stopping, 0, 1) != 0)
+    {
+        smp_stop_self();
+    }
+    if (g_cpus_online <= 1 || !apic_enabled())
+    {
+        return;
+    }
+    lapic_send_nmi_others();
+    deadline = ktime_ns() + (uint64_t)SMP_STOP_TIMEOUT_US * NSEC_PER_USEC;
+    while (g_smp_stopped < g_cpus_online - 1 && ktime_ns() < deadline)
+    {
+        cpu_relax();
+    }
+}
+
+static void smp_flush_page(void *arg)
+{
+    invlpg((uint32_t)arg);
+}
+
+void smp_tlb_shootdown(uint32_t virt)
+{
+    if (g_cpus_online <= 1)
+    {
+        return;
+    }
+    smp_call_function(SMP_ALL_CPUS & ~SMP_CPU(smp_processor_id()),
+                      smp_flush_page, (void *)virt, TRUE);
+}
+
+static uint64_t smp_ping(uint32_t cpu)
+{
+    uint64_t    start;
+
+    start = rdtsc();
+    if (smp_run_on(cpu, smp_noop, NULL) != 0)
+    {
+        return (0);
+    }
+    smp_wait(cpu);
+    return (rdtsc() - start);
+}
+
+static void smp_bench_count(void *arg)
+{
+    (void)arg;
+    atomic_inc(&g_bench_calls);
+}
+
+static uint32_t smp_bench_avg(uint64_t total, uint32_t count)
+{
+    return ((uint32_t)k_udivmod64(total, count, NULL));
+}
+
+static void smp_ipi_bench_cpu(uint32_t cpu, uint32_t iterations)
+{
+    uint64_t    start;
+    uint64_t    cycles;
+    uint64_t    total;
+    uint64_t    mailbox;
+    uint32_t    min;
+    uint32_t    kicks;
+    uint32_t    i;
+
+    total = 0;
+    min = 0xFFFFFFFFU;
+    for (i = 0; i < iterations; i++)
+    {
+        start = rdtsc();
+        smp_call_function(SMP_CPU(cpu), smp_noop, NULL, TRUE);
+        cycles = rdtsc() - start;
+        total += cycles;
+        if (cycles < min)
+        {
+            min = (uint32_t)cycles;
+        }
+    }
+    mailbox = 0;
+    for (i = 0; i < iterations; i++)
+    {
+        mailbox += smp_ping(cpu);
+    }
+    kicks = g_callq[cpu].kicks;
+    g_bench_calls = 0;
+    start = rdtsc();
+    for (i = 0; i < SMP_IPI_BENCH_BATCH; i++)
+    {
+        smp_call_function(SMP_CPU(cpu), smp_bench_count, NULL, FALSE);
+    }
+    while (g_bench_calls < SMP_IPI_BENCH_BATCH)
+    {
+        cpu_relax();
+    }
+    cycles = rdtsc() - start;
+    kicks = g_callq[cpu].kicks - kicks;
+    printk("  cpu %u  call+wait min %u avg %u cycles (%u ns)  mailbox %u\n",
+           cpu, min, smp_bench_avg(total, iterations),
+           (uint32_t)cycles_to_ns(k_udivmod64(total, iterations, NULL)),
+           smp_bench_avg(mailbox, iterations));
+    printk("         %u async calls: %u cycles each, %u IPI(s)\n",
+           SMP_IPI_BENCH_BATCH, smp_bench_avg(cycles, SMP_IPI_BENCH_BATCH),
+           kicks);
+}
+
+void smp_ipi_benchmark(uint32_t iterations)
+{
+    t_cpumask   others;
+    uint64_t    start;
+    uint64_t    total;
+    uint32_t    self;
+    uint32_t    i;
+
+    if (g_cpus_online <= 1)
+    {
+        printk("ipibench: only one CPU is online\n");
+        return;
+    }
+    self = smp_processor_id();
+    printk("\n=== IPI round trip from cpu %u (%u calls each) ===\n",
+           self, iterations);
+    others = 0;
+    for (i = 0; i < g_cpu_count; i++)
+    {
+        if (i != self && g_cpus[i].online)
+        {
+            others |= SMP_CPU(i);
+            smp_ipi_bench_cpu(i, iterations);
+        }
+    }
+    total = 0;
+    for (i = 0; i < iterations; i++)
+    {
+        start = rdtsc();
+        smp_call_function(others, smp_noop, NULL, TRUE);
+        total += rdtsc() - start;
+    }
+    printk("  all %u others  call+wait avg %u cycles (%u ns)\n",
+           g_cpus_online - 1, smp_bench_avg(total, iterations),
+           (uint32_t)cycles_to_ns(k_udivmod64(total, iterations, NULL)));
+    printk("\n");
+}
+
+void smp_print(void)
+{
+    const t_cpu *cpu;
+    uint32_t    i;
+
+    printk("\n=== CPUs (%u online, %u in the MADT) ===\n",
+           g_cpus_online, g_cpu_count);
+    for (i = 0; i < g_cpu_count; i++)
+    {
+        cpu = &g_cpus[i];
+        printk("  cpu %u  apic %u  acpi %u  ", cpu->id, cpu->apic_id,
+               cpu->acpi_id);
+        if (i == 0)
+        {
+            printk("bsp  tss 0x%x  gs 0x%x  irqs %u\n", GDT_TSS_SELECTOR(i),
+                   GDT_PERCPU_SELECTOR(i), percpu_get(i)->irqs);
+            continue;
+        }
+        if (!cpu->online)
+        {
+            printk("offline\n");
+            continue;
+        }
+        printk("%s  tss 0x%x  gs 0x%x  stack 0x%x  boot %u us\n",
+               cpu->work_fn != NULL ? "busy" : "idle",
+               GDT_TSS_SELECTOR(i), GDT_PERCPU_SELECTOR(i), cpu->stack,
+               (uint32_t)k_udivmod64(cycles_to_ns(cpu->boot_cycles),
+                                     NSEC_PER_USEC, NULL));
+        printk("         jobs %u  calls %u (%u IPIs)  irqs %u  ping %u cycles\n",
+               cpu->jobs, g_callq[i].run, g_callq[i].ipis, percpu_get(i)->irqs,
+               (uint32_t)smp_ping(i));
+    }
+    workq_print_stats();
+    printk("\n");
+}
@@ -0,0 +1,160 @@
+#include "kernel.h"
+#include "../include/softirq.h"
+#include "../include/idt.h"
+#include "../include/cpu.h"
+#include "../include/percpu.h"
+#include "../include/atomic.h"
+
+static t_softirq_handler    g_softirq_handlers[SOFTIRQ_COUNT];
+static uint32_t             g_softirq_runs[SOFTIRQ_COUNT];
+
+static const char *const    g_softirq_names[SOFTIRQ_COUNT] = {
+    "timer", "tasklet"
+};
+
+static void tasklet_action(void)
+{
+    t_percpu    *cpu;
+    t_tasklet   *list;
+    t_tasklet   *tasklet;
+    uint32_t    flags;
+
+    flags = irq_save();
+    cpu = this_cpu_ptr();
+    list = cpu->tasklet_head;
+    cpu->tasklet_head = NULL;
+    cpu->tasklet_tail = &cpu->tasklet_head;
+    irq_restore(flags);
+    while (list != NULL)
+    {
+        tasklet = list;
+        list = list->next;
+        tasklet->next = NULL;
+        tasklet->state &= ~TASKLET_SCHEDULED;
+        tasklet->runs++;
+        tasklet->func(tasklet->data);
+    }
+}
+
+void __init softirq_init(void)
+{
+    softirq_register(SOFTIRQ_TASKLET, tasklet_action);
+}
+
+void softirq_register(uint32_t nr, t_softirq_handler handler)
+{
+    KERNEL_ASSERT(nr < SOFTIRQ_COUNT, "Invalid softirq number");
+    g_softirq_handlers[nr] = handler;
+}
+
+void raise_softirq(uint32_t nr)
+{
+    this_cpu_or(softirq_pending, 1U << nr);
+}
+
+void softirq_run_pending(void)
+{
+    uint32_t    flags;
+    uint32_t    pending;
+    uint32_t    restart;
+    uint32_t    nr;
+
+    if (this_cpu_read(bh_disable_count) != 0 ||
+        this_cpu_read(softirq_active) != 0)
+    {
+        return;
+    }
+    flags = irq_save();
+    this_cpu_write(softirq_active, 1);
+    restart = SOFTIRQ_MAX_RESTART;
+    while (this_cpu_read(softirq_pending) != 0 && restart > 0)
+    {
+        pending = this_cpu_read(softirq_pending);
+        this_cpu_write(softirq_pending, 0);
+        __asm__ volatile ("sti" : : : "memory");
+        while (pending != 0)
+        {
+            nr = (uint32_t)__builtin_ctz(pending);
+            pending &= pending - 1;
+            if (g_softirq_handlers[nr] != NULL)
+            {
+                g_softirq_runs[nr]++;
+                g_softirq_handlers[nr]();
+            }
+        }
+        __asm__ volatile ("cli" : : : "memory");
+        restart--;
+    }
+    this_cpu_write(softirq_active, 0);
+    irq_restore(flags);
+}
+
+void do_softirq(void)
+{
+    if (this_cpu_read(irq_depth) == 0)
+    {
+        softirq_run_pending();
+    }
+}
+
+uint32_t softirq_runs(uint32_t nr)
+{
+    if (nr >= SOFTIRQ_COUNT)
+    {
+        return (0);
+    }
+    return (g_softirq_runs[nr]);
+}
+
+bool_t in_softirq(void)
+{
+    return ((bool_t)(this_cpu_read(bh_disable_count) != 0 ||
+                     this_cpu_read(softirq_active) != 0));
+}
+
+void local_bh_disable(void)
+{
+    this_cpu_inc(bh_disable_count);
+}
+
+void local_bh_enable(void)
+{
+    KERNEL_ASSERT(this_cpu_read(bh_disable_count) != 0,
+                  "Unbalanced local_bh_enable");
+    this_cpu_dec(bh_disable_count);
+    if (this_cpu_read(bh_disable_count) == 0 &&
+        this_cpu_read(softirq_pending) != 0)
+    {
+        do_softirq();
+    }
+}
+
+void tasklet_schedule(t_tasklet *tasklet)
+{
+    t_percpu    *cpu;
+    uint32_t    flags;
+
+    if (atomic_cmpxchg(&tasklet->state, 0, TASKLET_SCHEDULED) != 0)
+    {
+        return;
+    }
+    flags = irq_save();
+    cpu = this_cpu_ptr();
+    tasklet->next = NULL;
+    *cpu->tasklet_tail = tasklet;
+    cpu->tasklet_tail = &tasklet->next;
+    this_cpu_or(softirq_pending, 1U << SOFTIRQ_TASKLET);
+    irq_restore(flags);
+}
+
+void softirq_print(void)
+{
+    uint32_t    i;
+
+    printk("  softirq:");
+    for (i = 0; i < SOFTIRQ_COUNT; i++)
+    {
+        printk(" %s %u", g_softirq_names[i], g_softirq_runs[i]);
+    }
+    printk("  pending 0x%x\n", this_cpu_read(softirq_pending));
+}
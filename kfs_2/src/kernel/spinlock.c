@@ -0,0 +1,225 @@
+#include "kernel.h"
+#include "../include/spinlock.h"
+#include "../lib/math.h"
+#include "../lib/string.h"
+
+#if CONFIG_LOCKSTAT
+
+static t_lockstat *volatile g_lockstat[LOCKSTAT_MAX];
+static volatile uint32_t    g_lockstat_count;
+static volatile uint32_t    g_lockstat_dropped;
+
+static void lockstat_register(t_lockstat *stat)
+{
+    uint32_t    slot;
+
+    if (stat->registered != 0 || atomic_cmpxchg(&stat->registered, 0, 1) != 0)
+    {
+        return;
+    }
+    slot = atomic_fetch_add(&g_lockstat_count, 1);
+    if (slot >= LOCKSTAT_MAX)
+    {
+        atomic_inc(&g_lockstat_dropped);
+        return;
+    }
+    g_lockstat[slot] = stat;
+}
+
+void lockstat_acquired(t_lockstat *stat, bool_t contended, uint64_t wait)
+{
+    lockstat_register(stat);
+    stat->acquisitions++;
+    if (contended)
+    {
+        stat->contended++;
+        stat->wait_cycles += wait;
+        if (wait > stat->wait_max)
+        {
+            stat->wait_max = wait;
+        }
+    }
+    stat->hold_start = rdtsc();
+}
+
+void lockstat_released(t_lockstat *stat)
+{
+    uint64_t    held;
+
+    held = rdtsc() - stat->hold_start;
+    stat->hold_cycles += held;
+    if (held > stat->hold_max)
+    {
+        stat->hold_max = held;
+    }
+}
+
+void lockstat_read(t_lockstat *stat, bool_t contended)
+{
+    lockstat_register(stat);
+    atomic_inc(&stat->reads);
+    if (contended)
+    {
+        atomic_inc(&stat->read_contended);
+    }
+}
+
+#endif
+
+void spin_lock_init(t_spinlock *lock, const char *name)
+{
+    lock->next = 0;
+    lock->owner = 0;
+#if CONFIG_LOCKSTAT
+    k_memset(&lock->stat, 0, sizeof(lock->stat));
+    lock->stat.name = name;
+#else
+    (void)name;
+#endif
+}
+
+void spin_lock_slow(t_spinlock *lock, uint32_t ticket)
+{
+#if CONFIG_LOCKSTAT
+    uint64_t    start;
+
+    start = rdtsc();
+#endif
+    while (lock->owner != ticket)
+    {
+        cpu_relax();
+    }
+    LOCKSTAT_ACQUIRED(lock, TRUE, rdtsc() - start);
+}
+
+void read_lock_slow(t_rwlock *lock)
+{
+    uint32_t    mask;
+    uint32_t    state;
+
+    mask = irqs_disabled() ? RWLOCK_WRITER : RWLOCK_WRITER | RWLOCK_WAITING;
+    while (1)
+    {
+        state = lock->state;
+        if ((state & mask) == 0 &&
+            atomic_cmpxchg(&lock->state, state, state + 1) == state)
+        {
+            break;
+        }
+        cpu_relax();
+    }
+    LOCKSTAT_READ(lock, TRUE);
+}
+
+void write_lock_slow(t_rwlock *lock)
+{
+    uint32_t    state;
+#if CONFIG_LOCKSTAT
+    uint64_t    start;
+
+    start = rdtsc();
+#endif
+    while (1)
+    {
+        state = lock->state;
+        if ((state & ~RWLOCK_WAITING) == 0 &&
+            atomic_cmpxchg(&lock->state, state, RWLOCK_WRITER) == state)
+        {
+            break;
+        }
+        if ((state & RWLOCK_WAITING) == 0)
+        {
+            atomic_cmpxchg(&lock->state, state, state | RWLOCK_WAITING);
+        }
+        cpu_relax();
+    }
+    LOCKSTAT_ACQUIRED(lock, TRUE, rdtsc() - start);
+}
+
+#if CONFIG_LOCKSTAT
+
+static uint32_t lockstat_avg(uint64_t total, uint32_t count)
+{
+    if (count == 0)
+    {
+        return (0);
+    }
+    return ((uint32_t)k_udivmod64(total, count, NULL));
+}
+
+void lockstat_reset(void)
+{
+    t_lockstat  *stat;
+    uint32_t    flags;
+    uint32_t    count;
+    uint32_t    i;
+
+    flags = irq_save();
+    count = g_lockstat_count < LOCKSTAT_MAX ? g_lockstat_count : LOCKSTAT_MAX;
+    for (i = 0; i < count; i++)
+    {
+        stat = g_lockstat[i];
+        if (stat == NULL)
+        {
+            continue;
+        }
+        stat->acquisitions = 0;
+        stat->contended = 0;
+        stat->reads = 0;
+        stat->read_contended = 0;
+        stat->wait_cycles = 0;
+        stat->wait_max = 0;
+        stat->hold_cycles = 0;
+        stat->hold_max = 0;
+    }
+    irq_restore(flags);
+}
+
+void lockstat_print(void)
+{
+    const t_lockstat    *stat;
+    uint32_t            count;
+    uint32_t            i;
+
+    count = g_lockstat_count < LOCKSTAT_MAX ? g_lockstat_count : LOCKSTAT_MAX;
+    printk("\n=== Lock statistics (%u locks, cycles) ===\n", count);
+    for (i = 0; i < count; i++)
+    {
+        stat = g_lockstat[i];
+        if (stat == NULL)
+        {
+            continue;
+        }
+        printk("  %s  acquired %u  contended %u", stat->name,
+               stat->acquisitions, stat->contended);
+        if (stat->reads != 0)
+        {
+            printk("  reads %u  read contended %u", stat->reads,
+                   stat->read_contended);
+        }
+        printk("\n      wait avg %u max %u  hold avg %u max %u\n",
+               lockstat_avg(stat->wait_cycles, stat->contended),
+               (uint32_t)stat->wait_max,
+               lockstat_avg(stat->hold_cycles, stat->acquisitions),
+               (uint32_t)stat->hold_max);
+    }
+    if (g_lockstat_dropped != 0)
+    {
+        printk("  %u locks not tracked (LOCKSTAT_MAX %u)\n",
+               g_lockstat_dropped, LOCKSTAT_MAX);
+    }
+    printk("\n");
+}
+
+#else
+
+void lockstat_reset(void)
+{
+}
+
+void lockstat_print(void)
+{
+    printk("Lock statistics are disabled (rebuild with LOCKSTAT=1)\n");
+}
+
+#endif
@@ -1,8 +1,16 @@
 #include "stack.h"
 #include "types.h"
+#include "pmm.h"
+#include "paging.h"
 
 extern void printk(const char *fmt, ...);
 
+extern uint8_t  stack_bottom[];
+extern uint8_t  stack_top[];
+
+static t_stack_region   g_stacks[STACK_MAX_REGIONS];
+static uint32_t         g_stack_slots[STACK_AREA_SLOTS / 32];
+
 uint32_t    stack_get_esp(void)
 {
     uint32_t    esp;
@@ -153,7 +161,8 @@ void    stack_trace(uint32_t max_frames)
     while (frame != NULL && frame_num < max_frames)
     {
 
-        if ((uint32_t)frame < 0x1000 || (uint32_t)frame > 0xFFFFFF00)
+        if (stack_find((uint32_t)frame) == NULL ||
+            stack_find((uint32_t)frame + sizeof(t_stack_frame) - 1) == NULL)
         {
             printk("  #%d: [Invalid frame pointer: 0x%x]\n",
                    frame_num, (uint32_t)frame);
@@ -240,3 +249,211 @@ void    stack_print(void)
     printk("         END OF STACK DUMP             \n");
     printk("========================================\n\n");
 }
+
+void    stack_paint(uint32_t base, uint32_t size)
+{
+    uint32_t    *word;
+    uint32_t    i;
+
+    word = (uint32_t *)base;
+    for (i = 0; i < size / sizeof(uint32_t); i++)
+    {
+        word[i] = STACK_PAINT_PATTERN;
+    }
+}
+
+uint32_t    stack_high_water(uint32_t base, uint32_t size)
+{
+    const uint32_t  *word;
+    uint32_t        untouched;
+
+    word = (const uint32_t *)base;
+    untouched = 0;
+    while (untouched < size / sizeof(uint32_t) &&
+           word[untouched] == STACK_PAINT_PATTERN)
+    {
+        untouched++;
+    }
+    return (size - untouched * (uint32_t)sizeof(uint32_t));
+}
+
+static int  stack_add_region(const char *name, uint32_t base, uint32_t size,
+                             bool_t guarded, bool_t owned)
+{
+    uint32_t    i;
+
+    for (i = 0; i < STACK_MAX_REGIONS; i++)
+    {
+        if (g_stacks[i].size == 0)
+        {
+            g_stacks[i].name = name;
+            g_stacks[i].base = base;
+            g_stacks[i].size = size;
+            g_stacks[i].guarded = guarded;
+            g_stacks[i].owned = owned;
+            return (0);
+        }
+    }
+    return (-1);
+}
+
+int     stack_register(const char *name, uint32_t base, uint32_t size,
+                       bool_t guarded)
+{
+    return (stack_add_region(name, base, size, guarded, FALSE));
+}
+
+void    stack_unregister(uint32_t base)
+{
+    uint32_t    i;
+
+    for (i = 0; i < STACK_MAX_REGIONS; i++)
+    {
+        if (g_stacks[i].size != 0 && g_stacks[i].base == base)
+        {
+            g_stacks[i].size = 0;
+            g_stacks[i].name = NULL;
+            return;
+        }
+    }
+}
+
+const t_stack_region    *stack_find(uint32_t addr)
+{
+    uint32_t    i;
+
+    for (i = 0; i < STACK_MAX_REGIONS; i++)
+    {
+        if (g_stacks[i].size != 0 && addr >= g_stacks[i].base &&
+            addr - g_stacks[i].base < g_stacks[i].size)
+        {
+            return (&g_stacks[i]);
+        }
+    }
+    return (NULL);
+}
+
+static void stack_unmap_range(uint32_t base, uint32_t top)
+{
+    phys_addr_t frame;
+
+    while (base < top)
+    {
+        frame = paging_virt_to_phys(base);
+        if (frame != 0)
+        {
+            paging_unmap(base);
+            pmm_free_frame(frame);
+        }
+        base += PAGE_SIZE;
+    }
+}
+
+uint32_t    stack_alloc(const char *name, uint32_t size)
+{
+    uint32_t    slot;
+    uint32_t    top;
+    uint32_t    base;
+    uint32_t    addr;
+    phys_addr_t frame;
+
+    size = (size + PAGE_MASK) & ~(uint32_t)PAGE_MASK;
+    if (size == 0 || size > STACK_AREA_SLOT_SIZE - PAGE_SIZE)
+    {
+        return (0);
+    }
+    for (slot = 0; slot < STACK_AREA_SLOTS; slot++)
+    {
+        if ((g_stack_slots[slot / 32] & (1U << (slot % 32))) == 0)
+        {
+            break;
+        }
+    }
+    if (slot == STACK_AREA_SLOTS)
+    {
+        return (0);
+    }
+
+
+    top = STACK_AREA_BASE + (slot + 1) * STACK_AREA_SLOT_SIZE;
+    base = top - size;
+    for (addr = base; addr < top; addr += PAGE_SIZE)
+    {
+        frame = pmm_alloc_frame();
+        if (frame == 0 || paging_map(addr, frame, MAP_KERNEL_DATA) != 0)
+        {
+            if (frame != 0)
+            {
+                pmm_free_frame(frame);
+            }
+            stack_unmap_range(base, addr);
+            return (0);
+        }
+    }
+    if (stack_add_region(name, base, size, TRUE, TRUE) != 0)
+    {
+        stack_unmap_range(base, top);
+        return (0);
+    }
+    stack_paint(base, size);
+    g_stack_slots[slot / 32] |= (1U << (slot % 32));
+    return (base);
+}
+
+void    stack_free(uint32_t base)
+{
+    const t_stack_region    *region;
+    uint32_t                slot;
+
+    region = stack_find(base);
+    if (region == NULL || !region->owned || region->base != base)
+    {
+        return;
+    }
+    slot = (base - STACK_AREA_BASE) / STACK_AREA_SLOT_SIZE;
+    stack_unmap_range(base, base + region->size);
+    stack_unregister(base);
+    g_stack_slots[slot / 32] &= ~(1U << (slot % 32));
+}
+
+void    __init stack_init(void)
+{
+    uint32_t    base;
+    uint32_t    size;
+
+    base = (uint32_t)stack_bottom;
+    size = (uint32_t)(stack_top - stack_bottom);
+
+
+    if (paging_enabled())
+    {
+        paging_unmap(base - PAGE_SIZE);
+    }
+    stack_register("boot", base, size, paging_enabled());
+}
+
+void    stack_print_usage(void)
+{
+    uint32_t    i;
+    uint32_t    peak;
+    uint32_t    esp;
+
+    esp = stack_get_esp();
+    printk("\n=== Stack Usage (high-water marks) ===\n");
+    for (i = 0; i < STACK_MAX_REGIONS; i++)
+    {
+        if (g_stacks[i].size == 0)
+        {
+            continue;
+        }
+        peak = stack_high_water(g_stacks[i].base, g_stacks[i].size);
+        printk("  %s: 0x%x-0x%x  size %u KB  peak %u B (%u%%)%s%s\n",
+               g_stacks[i].name, g_stacks[i].base,
+               g_stacks[i].base + g_stacks[i].size, g_stacks[i].size / 1024,
+               peak, (peak * 100) / g_stacks[i].size,
+               g_stacks[i].guarded ? "  [guard]" : "",
+               (esp >= g_stacks[i].base &&
+                esp - g_stacks[i].base < g_stacks[i].size) ? "  <- ESP" : "");
+    }
+    printk("\n");
+}
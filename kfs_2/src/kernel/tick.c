@@ -0,0 +1,203 @@
+#include "kernel.h"
+#include "../include/tick.h"
+#include "../include/ktime.h"
+#include "../include/cpu.h"
+#include "../include/softirq.h"
+#include "../include/timer.h"
+#include "../include/sched.h"
+#include "../lib/math.h"
+
+static const t_clockevent   *g_clockevent;
+static uint32_t             g_tick_mode = CLOCK_EVT_PERIODIC;
+static uint64_t             g_tick_last_ns;
+static bool_t               g_tick_idle;
+static t_idle_stats         g_idle;
+
+static void tick_program(uint64_t target_ns, uint64_t now)
+{
+    uint64_t    delta;
+
+    delta = (target_ns > now) ? target_ns - now : 0;
+    if (delta < g_clockevent->min_delta_ns)
+    {
+        delta = g_clockevent->min_delta_ns;
+    }
+    if (delta > g_clockevent->max_delta_ns)
+    {
+        delta = g_clockevent->max_delta_ns;
+    }
+    g_clockevent->set_oneshot(delta);
+}
+
+static void tick_update_jiffies(uint64_t now)
+{
+    uint64_t    ticks;
+
+    if (now < g_tick_last_ns + TICK_NSEC)
+    {
+        return;
+    }
+    ticks = k_udivmod64(now - g_tick_last_ns, TICK_NSEC, NULL);
+    g_tick_last_ns += ticks * TICK_NSEC;
+    time_tick((uint32_t)ticks);
+    raise_softirq(SOFTIRQ_TIMER);
+}
+
+static void idle_account_window(uint64_t now)
+{
+    if (now - g_idle.window_start_ns < NSEC_PER_SEC)
+    {
+        return;
+    }
+    g_idle.wakeups_last_sec = g_idle.window_wakeups;
+    g_idle.timer_irqs_last_sec = g_idle.window_timer_irqs;
+    g_idle.window_wakeups = 0;
+    g_idle.window_timer_irqs = 0;
+    g_idle.window_start_ns = now;
+}
+
+void __init tick_init(const t_clockevent *clockevent)
+{
+    g_clockevent = clockevent;
+    if (tsc_get_info()->mult == 0 || clockevent->set_oneshot == NULL)
+    {
+        g_tick_mode = CLOCK_EVT_PERIODIC;
+        clockevent->set_periodic(HZ);
+        return;
+    }
+    g_tick_last_ns = ktime_ns();
+    g_idle.window_start_ns = g_tick_last_ns;
+    g_tick_mode = CLOCK_EVT_ONESHOT;
+    tick_program(g_tick_last_ns + TICK_NSEC, g_tick_last_ns);
+}
+
+void tick_handle(void)
+{
+    uint64_t    now;
+
+    g_idle.timer_irqs++;
+    g_idle.window_timer_irqs++;
+    sched_tick();
+    if (g_tick_mode == CLOCK_EVT_PERIODIC)
+    {
+        time_tick(1);
+        raise_softirq(SOFTIRQ_TIMER);
+        return;
+    }
+    now = ktime_ns();
+    tick_update_jiffies(now);
+    idle_account_window(now);
+    if (!g_tick_idle)
+    {
+        tick_program(g_tick_last_ns + TICK_NSEC, now);
+    }
+}
+
+uint32_t tick_mode(void)
+{
+    return (g_tick_mode);
+}
+
+const t_clockevent *tick_clockevent(void)
+{
+    return (g_clockevent);
+}
+
+static void tick_nohz_idle_enter(void)
+{
+    uint64_t    now;
+    uint64_t    next;
+    uint64_t    jiffies;
+
+    now = ktime_ns();
+    tick_update_jiffies(now);
+    jiffies = g_jiffies;
+    next = timer_next_expiry();
+    if (next <= jiffies + 1)
+    {
+        return;
+    }
+    g_tick_idle = TRUE;
+    if (next - jiffies > k_udivmod64(g_clockevent->max_delta_ns, TICK_NSEC, NULL))
+    {
+        tick_program(now + g_clockevent->max_delta_ns, now);
+    }
+    else
+    {
+        tick_program(g_tick_last_ns + (next - jiffies) * TICK_NSEC, now);
+    }
+}
+
+static void tick_nohz_idle_exit(uint64_t slept_from)
+{
+    uint64_t    now;
+    uint64_t    slept;
+
+    now = ktime_ns();
+    slept = now - slept_from;
+    g_idle.sleep_ns += slept;
+    if (slept > g_idle.longest_sleep_ns)
+    {
+        g_idle.longest_sleep_ns = slept;
+    }
+    idle_account_window(now);
+    if (!g_tick_idle)
+    {
+        return;
+    }
+    g_tick_idle = FALSE;
+    tick_update_jiffies(now);
+    tick_program(g_tick_last_ns + TICK_NSEC, now);
+}
+
+void cpu_idle(void)
+{
+    uint64_t    start;
+
+    g_idle.entries++;
+    if (g_tick_mode != CLOCK_EVT_ONESHOT)
+    {
+        __asm__ volatile ("sti; hlt" : : : "memory");
+        g_idle.wakeups++;
+        g_idle.window_wakeups++;
+        return;
+    }
+    tick_nohz_idle_enter();
+    start = ktime_ns();
+    __asm__ volatile ("sti; hlt; cli" : : : "memory");
+    g_idle.wakeups++;
+    g_idle.window_wakeups++;
+    tick_nohz_idle_exit(start);
+    __asm__ volatile ("sti" : : : "memory");
+}
+
+void idle_print_stats(void)
+{
+    uint32_t    uptime_ms;
+    uint32_t    sleep_ms;
+    uint32_t    residency;
+
+    uptime_ms = (uint32_t)k_udivmod64(ktime_ns(), NSEC_PER_MSEC, NULL);
+    sleep_ms = (uint32_t)k_udivmod64(g_idle.sleep_ns, NSEC_PER_MSEC, NULL);
+    residency = 0;
+    if (uptime_ms != 0)
+    {
+        residency = (uint32_t)k_udivmod64((uint64_t)sleep_ms * 100, uptime_ms,
+                                          NULL);
+    }
+    printk("\n=== Idle / Tick Statistics ===\n");
+    printk("  Clockevent:   %s, %s\n", g_clockevent != NULL ?
+           g_clockevent->name : "none",
+           g_tick_mode == CLOCK_EVT_ONESHOT ? "one-shot (tickless idle)" :
+           "periodic");
+    printk("  Idle entries: %u  wakeups: %u\n", g_idle.entries,
+           g_idle.wakeups);
+    printk("  Last second:  %u wakeups, %u timer interrupts\n",
+           g_idle.wakeups_last_sec, g_idle.timer_irqs_last_sec);
+    printk("  Timer IRQs:   %u total (%u Hz tick)\n", g_idle.timer_irqs,
+           (uint32_t)HZ);
+    printk("  Sleep:        %u ms total, longest %llu us, %u%% idle\n",
+           sleep_ms, k_udivmod64(g_idle.longest_sleep_ns, NSEC_PER_USEC, NULL),
+           residency);
+    printk("\n");
+}
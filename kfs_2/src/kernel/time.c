@@ -0,0 +1,108 @@
+#include "kernel.h"
+#include "../include/time.h"
+#include "../include/cpu.h"
+#include "../include/ktime.h"
+#include "../include/tick.h"
+#include "../include/pit.h"
+#include "../include/hpet.h"
+#include "../include/apic.h"
+#include "../include/cmdline.h"
+#include "../include/atomic.h"
+#include "../lib/math.h"
+
+volatile uint64_t   g_jiffies;
+static volatile uint32_t    g_jiffies_seq;
+
+static bool_t __init time_want(const char *name)
+{
+    char    clock[8];
+
+    return ((bool_t)(cmdline_get("clock", clock, sizeof(clock)) &&
+                     k_strcmp(clock, name) == 0));
+}
+
+static bool_t __init time_want_hpet(void)
+{
+    const t_hpet_info   *hpet;
+
+    if (time_want("pit"))
+    {
+        return (FALSE);
+    }
+    hpet = hpet_get_info();
+    return ((bool_t)(hpet->present && hpet->legacy_route && hpet->periodic));
+}
+
+void __init time_init(void)
+{
+    hpet_init();
+    tsc_init();
+    if (time_want("lapic") && lapic_timer_init() == 0)
+    {
+        tick_init(&g_lapic_clockevent);
+    }
+    else if (time_want_hpet())
+    {
+        hpet_enable_clockevent();
+        tick_init(&g_hpet_clockevent);
+    }
+    else
+    {
+        pit_init(HZ);
+        tick_init(&g_pit_clockevent);
+    }
+}
+
+void time_tick(uint32_t ticks)
+{
+    g_jiffies_seq++;
+    barrier();
+    g_jiffies += ticks;
+    barrier();
+    g_jiffies_seq++;
+}
+
+uint64_t jiffies_get(void)
+{
+    uint64_t    value;
+    uint32_t    seq;
+
+    do
+    {
+        seq = g_jiffies_seq;
+        barrier();
+        value = g_jiffies;
+        barrier();
+    } while ((seq & 1) != 0 || g_jiffies_seq != seq);
+    return (value);
+}
+
+uint64_t jiffies_to_ms(uint64_t jiffies)
+{
+    return (k_udivmod64(jiffies * 1000, HZ, NULL));
+}
+
+static void time_print_2digits(uint32_t value)
+{
+    printk("%u%u", value / 10, value % 10);
+}
+
+void time_print_uptime(void)
+{
+    uint64_t    jiffies;
+    uint64_t    seconds;
+    uint32_t    ticks;
+    uint32_t    hours;
+    uint32_t    rest;
+
+    jiffies = jiffies_get();
+    seconds = k_udivmod64(jiffies, HZ, &ticks);
+    hours = (uint32_t)k_udivmod64(seconds, 3600, &rest);
+    printk("up %u:", hours);
+    time_print_2digits(rest / 60);
+    printk(":");
+    time_print_2digits(rest % 60);
+    printk(".");
+    time_print_2digits(ticks * 100 / HZ);
+    printk(", %llu ticks at %u Hz\n", jiffies, (uint32_t)HZ);
+}
@@ -0,0 +1,349 @@
+#include "kernel.h"
+#include "../include/timer.h"
+#include "../include/time.h"
+#include "../include/softirq.h"
+#include "../include/cpu.h"
+#include "../include/pmm.h"
+#include "../lib/math.h"
+
+#define TIMER_BENCH_MAX_FRAMES  1024
+#define TIMER_PER_FRAME         (PAGE_SIZE / sizeof(t_timer))
+
+static t_list       g_tv1[TVR_SIZE];
+static t_list       g_tvn[TVN_LEVELS][TVN_SIZE];
+static uint64_t     g_timer_jiffies;
+static uint32_t     g_timer_count;
+
+static uint32_t     g_bench_frames[TIMER_BENCH_MAX_FRAMES];
+static uint32_t     g_bench_fired;
+
+static uint32_t tvn_shift(uint32_t level)
+{
+    return (TVR_BITS + level * TVN_BITS);
+}
+
+static void internal_add_timer(t_timer *timer)
+{
+    uint64_t    expires;
+    uint64_t    delta;
+    t_list      *vec;
+    uint32_t    level;
+
+    expires = timer->expires;
+    if (expires < g_timer_jiffies)
+    {
+        vec = &g_tv1[g_timer_jiffies & TVR_MASK];
+    }
+    else if (expires - g_timer_jiffies < TVR_SIZE)
+    {
+        vec = &g_tv1[expires & TVR_MASK];
+    }
+    else
+    {
+        delta = expires - g_timer_jiffies;
+        if (delta > TIMER_MAX_DELTA)
+        {
+            expires = g_timer_jiffies + TIMER_MAX_DELTA;
+        }
+        level = 0;
+        while (level < TVN_LEVELS - 1 && delta >= (1ULL << tvn_shift(level + 1)))
+        {
+            level++;
+        }
+        vec = &g_tvn[level][(expires >> tvn_shift(level)) & TVN_MASK];
+    }
+    list_add_tail(&timer->entry, vec);
+}
+
+static uint32_t cascade(uint32_t level, uint32_t index)
+{
+    t_list  work;
+    t_list  *node;
+
+    list_splice_init(&g_tvn[level][index], &work);
+    while (!list_empty(&work))
+    {
+        node = work.next;
+        list_del(node);
+        internal_add_timer(LIST_ENTRY(node, t_timer, entry));
+    }
+    return (index);
+}
+
+static void run_timers(void)
+{
+    t_list      work;
+    t_list      *node;
+    t_timer     *timer;
+    uint64_t    now;
+    uint32_t    flags;
+    uint32_t    index;
+    uint32_t    level;
+
+    flags = irq_save();
+    now = g_jiffies;
+    if (g_timer_count == 0 && g_timer_jiffies <= now)
+    {
+        g_timer_jiffies = now + 1;
+    }
+    while (g_timer_jiffies <= now)
+    {
+        index = (uint32_t)(g_timer_jiffies & TVR_MASK);
+        level = 0;
+        while (index == 0 && level < TVN_LEVELS &&
+               cascade(level, (uint32_t)(g_timer_jiffies >> tvn_shift(level))
+                       & TVN_MASK) == 0)
+        {
+            level++;
+        }
+        g_timer_jiffies++;
+        list_splice_init(&g_tv1[index], &work);
+        while (!list_empty(&work))
+        {
+            node = work.next;
+            list_del(node);
+            timer = LIST_ENTRY(node, t_timer, entry);
+            timer->pending = FALSE;
+            g_timer_count--;
+            irq_restore(flags);
+            timer->func(timer->data);
+            flags = irq_save();
+        }
+    }
+    irq_restore(flags);
+}
+
+void __init timers_init(void)
+{
+    uint32_t    i;
+    uint32_t    level;
+
+    for (i = 0; i < TVR_SIZE; i++)
+    {
+        list_init(&g_tv1[i]);
+    }
+    for (level = 0; level < TVN_LEVELS; level++)
+    {
+        for (i = 0; i < TVN_SIZE; i++)
+        {
+            list_init(&g_tvn[level][i]);
+        }
+    }
+    g_timer_jiffies = jiffies_get();
+    softirq_register(SOFTIRQ_TIMER, run_timers);
+}
+
+void timer_setup(t_timer *timer, void (*func)(void *data), void *data)
+{
+    list_init(&timer->entry);
+    timer->expires = 0;
+    timer->func = func;
+    timer->data = data;
+    timer->pending = FALSE;
+}
+
+int mod_timer(t_timer *timer, uint64_t expires)
+{
+    uint32_t    flags;
+    bool_t      was_pending;
+
+    flags = irq_save();
+    was_pending = timer->pending;
+    if (was_pending)
+    {
+        list_del(&timer->entry);
+    }
+    else
+    {
+        g_timer_count++;
+    }
+    timer->expires = expires;
+    timer->pending = TRUE;
+    internal_add_timer(timer);
+    irq_restore(flags);
+    return (was_pending ? 1 : 0);
+}
+
+void add_timer(t_timer *timer)
+{
+    KERNEL_ASSERT(!timer->pending, "add_timer on a pending timer");
+    mod_timer(timer, timer->expires);
+}
+
+int del_timer(t_timer *timer)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    if (!timer->pending)
+    {
+        irq_restore(flags);
+        return (0);
+    }
+    list_del(&timer->entry);
+    timer->pending = FALSE;
+    g_timer_count--;
+    irq_restore(flags);
+    return (1);
+}
+
+bool_t timer_pending(const t_timer *timer)
+{
+    return (timer->pending);
+}
+
+uint32_t timer_count(void)
+{
+    return (g_timer_count);
+}
+
+static uint64_t list_min_expiry(const t_list *head, uint64_t best)
+{
+    const t_list    *node;
+    const t_timer   *timer;
+
+    for (node = head->next; node != head; node = node->next)
+    {
+        timer = LIST_ENTRY(node, t_timer, entry);
+        if (timer->expires < best)
+        {
+            best = timer->expires;
+        }
+    }
+    return (best);
+}
+
+uint64_t timer_next_expiry(void)
+{
+    uint64_t    best;
+    uint32_t    flags;
+    uint32_t    start;
+    uint32_t    level;
+    uint32_t    i;
+    uint32_t    slot;
+
+    flags = irq_save();
+    best = TIME_NO_EXPIRY;
+    if (g_timer_count == 0)
+    {
+        irq_restore(flags);
+        return (best);
+    }
+    start = (uint32_t)(g_timer_jiffies & TVR_MASK);
+    for (i = 0; i < TVR_SIZE; i++)
+    {
+        slot = (start + i) & TVR_MASK;
+        if (!list_empty(&g_tv1[slot]))
+        {
+            best = list_min_expiry(&g_tv1[slot], best);
+            break;
+        }
+    }
+    for (level = 0; level < TVN_LEVELS; level++)
+    {
+        start = (uint32_t)(g_timer_jiffies >> tvn_shift(level)) & TVN_MASK;
+        if ((g_timer_jiffies & ((1ULL << tvn_shift(level)) - 1)) != 0)
+        {
+            start++;
+        }
+        for (i = 0; i < TVN_SIZE; i++)
+        {
+            slot = (start + i) & TVN_MASK;
+            if (!list_empty(&g_tvn[level][slot]))
+            {
+                best = list_min_expiry(&g_tvn[level][slot], best);
+                break;
+            }
+        }
+    }
+    irq_restore(flags);
+    return (best);
+}
+
+static void timer_bench_fire(void *data)
+{
+    (void)data;
+    g_bench_fired++;
+}
+
+static t_timer *timer_bench_get(uint32_t i)
+{
+    return ((t_timer *)g_bench_frames[i / TIMER_PER_FRAME] +
+            i % TIMER_PER_FRAME);
+}
+
+static uint32_t timer_bench_delta(uint32_t *seed, uint32_t i)
+{
+    *seed = *seed * 1103515245U + 12345U;
+    return (((*seed >> 4) & ((1U << (TVR_BITS + (i % 4) * TVN_BITS)) - 1)) + 1);
+}
+
+static uint32_t timer_bench_per_op(uint64_t cycles, uint32_t count)
+{
+    return ((uint32_t)k_udivmod64(cycles, count, NULL));
+}
+
+void timer_benchmark(uint32_t count)
+{
+    uint64_t    start;
+    uint64_t    add_cycles;
+    uint64_t    mod_cycles;
+    uint64_t    del_cycles;
+    uint64_t    now;
+    uint32_t    frames;
+    uint32_t    seed;
+    uint32_t    i;
+
+    if (count > TIMER_BENCH_MAX_FRAMES * TIMER_PER_FRAME)
+    {
+        count = TIMER_BENCH_MAX_FRAMES * TIMER_PER_FRAME;
+    }
+    frames = (count + TIMER_PER_FRAME - 1) / TIMER_PER_FRAME;
+    for (i = 0; i < frames; i++)
+    {
+        g_bench_frames[i] = (uint32_t)pmm_alloc_frame();
+        if (g_bench_frames[i] == 0)
+        {
+            printk("timerbench: out of memory after %u frames\n", i);
+            while (i > 0)
+            {
+                i--;
+                pmm_free_frame(g_bench_frames[i]);
+            }
+            return;
+        }
+    }
+    g_bench_fired = 0;
+    seed = 42;
+    now = jiffies_get();
+    start = rdtsc();
+    for (i = 0; i < count; i++)
+    {
+        timer_setup(timer_bench_get(i), timer_bench_fire, NULL);
+        timer_bench_get(i)->expires = now + timer_bench_delta(&seed, i);
+        add_timer(timer_bench_get(i));
+    }
+    add_cycles = rdtsc() - start;
+    start = rdtsc();
+    for (i = 0; i < count; i++)
+    {
+        mod_timer(timer_bench_get(i), now + timer_bench_delta(&seed, i + 1));
+    }
+    mod_cycles = rdtsc() - start;
+    start = rdtsc();
+    for (i = 0; i < count; i++)
+    {
+        del_timer(timer_bench_get(i));
+    }
+    del_cycles = rdtsc() - start;
+    for (i = 0; i < frames; i++)
+    {
+        pmm_free_frame(g_bench_frames[i]);
+    }
+    printk("\n=== Timer wheel benchmark (%u timers) ===\n", count);
+    printk("  add_timer: %u cycles/op\n", timer_bench_per_op(add_cycles, count));
+    printk("  mod_timer: %u cycles/op\n", timer_bench_per_op(mod_cycles, count));
+    printk("  del_timer: %u cycles/op\n", timer_bench_per_op(del_cycles, count));
+    printk("  fired during run: %u, still pending: %u\n\n", g_bench_fired,
+           g_timer_count);
+}
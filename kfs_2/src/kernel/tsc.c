@@ -0,0 +1,87 @@
+#include "kernel.h"
+#include "../include/ktime.h"
+#include "../include/cpu.h"
+#include "../include/pit.h"
+#include "../include/hpet.h"
+#include "../include/time.h"
+#include "../lib/math.h"
+
+static t_tsc_info   g_tsc;
+
+void tsc_set_khz(uint32_t khz)
+{
+    uint64_t    mult;
+    uint32_t    shift;
+
+    if (khz == 0)
+    {
+        return;
+    }
+    shift = 32;
+    mult = k_udivmod64((uint64_t)NSEC_PER_MSEC << shift, khz, NULL);
+    while (mult > 0xFFFFFFFFULL && shift > 0)
+    {
+        shift--;
+        mult = k_udivmod64((uint64_t)NSEC_PER_MSEC << shift, khz, NULL);
+    }
+    g_tsc.khz = khz;
+    g_tsc.mult = (uint32_t)mult;
+    g_tsc.shift = shift;
+}
+
+void __init tsc_init(void)
+{
+    t_cpuid_regs    regs;
+
+    regs = cpuid(1, 0);
+    if ((regs.edx & CPUID_FEAT_EDX_TSC) == 0)
+    {
+        return;
+    }
+    g_tsc.present = TRUE;
+    if (cpuid_max_extended() >= CPUID_LEAF_POWER)
+    {
+        regs = cpuid(CPUID_LEAF_POWER, 0);
+        g_tsc.invariant = (bool_t)((regs.edx & CPUID_POWER_EDX_INVTSC) != 0);
+    }
+    if (hpet_available())
+    {
+        g_tsc.reference = "HPET";
+        tsc_set_khz(hpet_calibrate_tsc_khz());
+    }
+    else
+    {
+        g_tsc.reference = "PIT";
+        tsc_set_khz(pit_calibrate_tsc_khz());
+    }
+    g_tsc.base = rdtsc();
+}
+
+const t_tsc_info *tsc_get_info(void)
+{
+    return (&g_tsc);
+}
+
+uint64_t ktime_cycles(void)
+{
+    return (rdtsc());
+}
+
+uint64_t cycles_to_ns(uint64_t cycles)
+{
+    uint64_t    low;
+    uint64_t    high;
+
+    low = ((cycles & 0xFFFFFFFFULL) * g_tsc.mult) >> g_tsc.shift;
+    high = ((cycles >> 32) * g_tsc.mult) << (32 - g_tsc.shift);
+    return (high + low);
+}
+
+uint64_t ktime_ns(void)
+{
+    if (g_tsc.mult == 0)
+    {
+        return (jiffies_get() * (NSEC_PER_SEC / HZ));
+    }
+    return (cycles_to_ns(rdtsc() - g_tsc.base));
+}
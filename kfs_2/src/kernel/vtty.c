@@ -1,8 +1,13 @@
 #include "../include/vtty.h"
+#include "../include/mouse.h"
+#include "../include/idt.h"
+#include "../include/softirq.h"
+#include "../include/spinlock.h"
 #include "../lib/string.h"
 
 static t_vtty           g_terminals[VTTY_COUNT];
 static uint8_t          g_current_terminal;
+static t_spinlock       g_vtty_lock = SPINLOCK_INIT("vtty");
 static volatile uint16_t *g_vga_buffer = (volatile uint16_t *)VGA_MEMORY_ADDRESS;
 
 static inline uint16_t vga_entry(char c, uint8_t color)
@@ -78,7 +83,40 @@ static void vtty_refresh_display(void)
     }
 }
 
-void vtty_init(void)
+static void vtty_scroll_tasklet(void *data)
+{
+    t_mouse_event   event;
+
+    (void)data;
+    while (mouse_has_event())
+    {
+        event = mouse_get_event();
+
+        if (event.delta_z > 0)
+        {
+            vtty_scroll_up(3);
+        }
+        else if (event.delta_z < 0)
+        {
+            vtty_scroll_down(3);
+        }
+    }
+}
+
+static t_tasklet    g_scroll_tasklet = TASKLET_INIT(vtty_scroll_tasklet, NULL);
+
+static int vtty_mouse_handler(t_regs *regs, void *ctx)
+{
+    (void)regs;
+    (void)ctx;
+    if (mouse_has_event())
+    {
+        tasklet_schedule(&g_scroll_tasklet);
+    }
+    return (IRQ_HANDLED);
+}
+
+void __init vtty_init(void)
 {
     uint8_t     i;
     size_t      j;
@@ -108,17 +146,25 @@ void vtty_init(void)
     }
 
     vtty_refresh_display();
+    irq_register(12, vtty_mouse_handler, NULL);
 }
 
 void vtty_switch(uint8_t terminal)
 {
-    if (terminal >= VTTY_COUNT || terminal == g_current_terminal)
+    uint32_t    flags;
+
+    if (terminal >= VTTY_COUNT)
     {
         return;
     }
 
-    g_current_terminal = terminal;
-    vtty_refresh_display();
+    flags = spin_lock_irqsave(&g_vtty_lock);
+    if (terminal != g_current_terminal)
+    {
+        g_current_terminal = terminal;
+        vtty_refresh_display();
+    }
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
 }
 
 uint8_t vtty_get_current(void)
@@ -164,7 +210,7 @@ static void vtty_scroll_content(void)
     term->cursor_row = VTTY_SCROLLBACK_LINES - 1;
 }
 
-void vtty_putchar(char c)
+static void vtty_putchar_locked(char c)
 {
     t_vtty  *term;
     size_t  index;
@@ -225,26 +271,42 @@ void vtty_putchar(char c)
     vtty_refresh_display();
 }
 
+void vtty_putchar(char c)
+{
+    uint32_t    flags;
+
+    flags = spin_lock_irqsave(&g_vtty_lock);
+    vtty_putchar_locked(c);
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
+}
+
 void vtty_putstr(const char *str)
 {
-    size_t i;
+    uint32_t    flags;
+    size_t      i;
 
     if (str == NULL)
     {
         return;
     }
 
+    flags = spin_lock_irqsave(&g_vtty_lock);
     i = 0;
     while (str[i] != '\0')
     {
-        vtty_putchar(str[i]);
+        vtty_putchar_locked(str[i]);
         i++;
     }
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
 }
 
 void vtty_set_color(uint8_t color)
 {
+    uint32_t    flags;
+
+    flags = spin_lock_irqsave(&g_vtty_lock);
     g_terminals[g_current_terminal].color = color;
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
 }
 
 void vtty_clear(void)
@@ -252,7 +314,9 @@ void vtty_clear(void)
     size_t      i;
     uint16_t    blank;
     t_vtty      *term;
+    uint32_t    flags;
 
+    flags = spin_lock_irqsave(&g_vtty_lock);
     term = &g_terminals[g_current_terminal];
     blank = vga_entry(' ', term->color);
 
@@ -269,13 +333,16 @@ void vtty_clear(void)
     term->total_lines = 0;
 
     vtty_refresh_display();
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
 }
 
 void vtty_scroll_up(size_t lines)
 {
-    t_vtty  *term;
-    size_t  max_offset;
+    t_vtty      *term;
+    size_t      max_offset;
+    uint32_t    flags;
 
+    flags = spin_lock_irqsave(&g_vtty_lock);
     term = &g_terminals[g_current_terminal];
 
 
@@ -295,12 +362,15 @@ void vtty_scroll_up(size_t lines)
     }
 
     vtty_refresh_display();
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
 }
 
 void vtty_scroll_down(size_t lines)
 {
-    t_vtty  *term;
+    t_vtty      *term;
+    uint32_t    flags;
 
+    flags = spin_lock_irqsave(&g_vtty_lock);
     term = &g_terminals[g_current_terminal];
 
     if (term->scroll_offset >= lines)
@@ -313,4 +383,5 @@ void vtty_scroll_down(size_t lines)
     }
 
     vtty_refresh_display();
+    spin_unlock_irqrestore(&g_vtty_lock, flags);
 }
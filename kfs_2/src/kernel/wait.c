@@ -0,0 +1,66 @@
+#include "kernel.h"
+#include "../include/wait.h"
+
+void wait_queue_init(t_wait_queue *wq)
+{
+    list_init(&wq->head);
+    wq->wakeups = 0;
+}
+
+void wait_entry_init(t_wait_entry *entry)
+{
+    list_init(&entry->node);
+    entry->task = current_task();
+}
+
+void prepare_to_wait(t_wait_queue *wq, t_wait_entry *entry)
+{
+    uint32_t    flags;
+
+    flags = irq_save();
+    if (list_empty(&entry->node))
+    {
+        list_add_tail(&entry->node, &wq->head);
+    }
+    irq_restore(flags);
+}
+
+void finish_wait(t_wait_queue *wq, t_wait_entry *entry)
+{
+    uint32_t    flags;
+
+    (void)wq;
+    flags = irq_save();
+    list_del(&entry->node);
+    irq_restore(flags);
+}
+
+uint32_t wake_up_nr(t_wait_queue *wq, uint32_t nr)
+{
+    t_wait_entry    *entry;
+    uint32_t        flags;
+    uint32_t        woken;
+
+    flags = irq_save();
+    woken = 0;
+    while (woken < nr && !list_empty(&wq->head))
+    {
+        entry = LIST_ENTRY(wq->head.next, t_wait_entry, node);
+        list_del(&entry->node);
+        sched_wakeup(entry->task);
+        woken++;
+    }
+    wq->wakeups += woken;
+    irq_restore(flags);
+    return (woken);
+}
+
+uint32_t wake_up(t_wait_queue *wq)
+{
+    return (wake_up_nr(wq, 0xFFFFFFFFU));
+}
+
+bool_t wait_queue_active(const t_wait_queue *wq)
+{
+    return ((bool_t)!list_empty(&wq->head));
+}
@@ -0,0 +1,348 @@
+#include "kernel.h"
+#include "../include/workq.h"
+#include "../include/smp.h"
+#include "../include/atomic.h"
+#include "../include/cpu.h"
+#include "../include/ktime.h"
+#include "../lib/math.h"
+
+static t_workq              g_workq[SMP_MAX_CPUS];
+static volatile uint32_t    g_workq_cpus = SMP_MAX_CPUS;
+
+static t_work               g_bench_work[WORKQ_BENCH_MAX];
+static volatile uint32_t    g_bench_done;
+
+static ALWAYS_INLINE int32_t workq_size(const t_workq *q)
+{
+    return ((int32_t)(q->bottom - q->top));
+}
+
+static int workq_push_local(t_workq *q, t_work *work)
+{
+    uint32_t    b;
+
+    b = q->bottom;
+    if ((int32_t)(b - q->top) >= WORKQ_SIZE)
+    {
+        return (-1);
+    }
+    q->slots[b & WORKQ_MASK] = work;
+    barrier();
+    q->bottom = b + 1;
+    return (0);
+}
+
+static t_work *workq_pop(t_workq *q)
+{
+    t_work      *work;
+    uint32_t    b;
+    uint32_t    t;
+
+    b = q->bottom - 1;
+    q->bottom = b;
+    smp_mb();
+    t = q->top;
+    if ((int32_t)(b - t) < 0)
+    {
+        q->bottom = t;
+        return (NULL);
+    }
+    work = q->slots[b & WORKQ_MASK];
+    if (b != t)
+    {
+        return (work);
+    }
+    if (atomic_cmpxchg(&q->top, t, t + 1) != t)
+    {
+        work = NULL;
+    }
+    q->bottom = t + 1;
+    return (work);
+}
+
+static t_work *workq_steal(t_workq *q, bool_t *aborted)
+{
+    t_work      *work;
+    uint32_t    t;
+    uint32_t    b;
+
+    t = q->top;
+    barrier();
+    b = q->bottom;
+    if ((int32_t)(b - t) <= 0)
+    {
+        return (NULL);
+    }
+    work = q->slots[t & WORKQ_MASK];
+    if (atomic_cmpxchg(&q->top, t, t + 1) != t)
+    {
+        *aborted = TRUE;
+        return (NULL);
+    }
+    return (work);
+}
+
+static t_workq *workq_busiest(uint32_t self, int32_t *size)
+{
+    t_workq     *victim;
+    uint32_t    cpus;
+    uint32_t    i;
+    int32_t     len;
+
+    victim = NULL;
+    *size = 0;
+    cpus = smp_cpu_count();
+    if (cpus > g_workq_cpus)
+    {
+        cpus = g_workq_cpus;
+    }
+    for (i = 0; i < cpus; i++)
+    {
+        len = workq_size(&g_workq[i]);
+        if (i != self && len > *size)
+        {
+            victim = &g_workq[i];
+            *size = len;
+        }
+    }
+    return (victim);
+}
+
+static t_work *workq_steal_half(uint32_t self)
+{
+    t_workq     *victim;
+    t_workq     *mine;
+    t_work      *first;
+    t_work      *work;
+    bool_t      aborted;
+    int32_t     size;
+    uint32_t    want;
+    uint32_t    got;
+
+    victim = workq_busiest(self, &size);
+    if (victim == NULL)
+    {
+        return (NULL);
+    }
+    mine = &g_workq[self];
+    want = ((uint32_t)size + 1) / 2;
+    first = NULL;
+    aborted = FALSE;
+    for (got = 0; got < want; got++)
+    {
+        work = workq_steal(victim, &aborted);
+        if (work == NULL)
+        {
+            break;
+        }
+        if (first == NULL)
+        {
+            first = work;
+        }
+        else if (workq_push_local(mine, work) != 0)
+        {
+            work->fn(work->arg);
+            mine->executed++;
+        }
+    }
+    if (got != 0)
+    {
+        mine->steals++;
+        mine->stolen += got;
+    }
+    if (aborted)
+    {
+        mine->aborts++;
+    }
+    return (first);
+}
+
+int workq_push(t_work *work)
+{
+    uint32_t    flags;
+    uint32_t    self;
+    int         ret;
+
+    flags = irq_save();
+    self = smp_processor_id();
+    work->cpu = self;
+    ret = workq_push_local(&g_workq[self], work);
+    irq_restore(flags);
+    if (ret == 0)
+    {
+        smp_kick_idle();
+    }
+    return (ret);
+}
+
+bool_t workq_run_one(void)
+{
+    t_workq     *q;
+    t_work      *work;
+    uint32_t    flags;
+    uint32_t    self;
+
+    flags = irq_save();
+    self = smp_processor_id();
+    q = &g_workq[self];
+    work = workq_pop(q);
+    if (work == NULL && self < g_workq_cpus)
+    {
+        work = workq_steal_half(self);
+    }
+    irq_restore(flags);
+    if (work == NULL)
+    {
+        return (FALSE);
+    }
+    q->executed++;
+    if (work->cpu != self)
+    {
+        q->migrations++;
+    }
+    work->fn(work->arg);
+    return (TRUE);
+}
+
+bool_t workq_has_work(void)
+{
+    uint32_t    self;
+    int32_t     size;
+
+    self = smp_processor_id();
+    if (workq_size(&g_workq[self]) > 0)
+    {
+        return (TRUE);
+    }
+    if (self >= g_workq_cpus)
+    {
+        return (FALSE);
+    }
+    return ((bool_t)(workq_busiest(self, &size) != NULL));
+}
+
+uint32_t workq_pending(uint32_t cpu)
+{
+    int32_t size;
+
+    if (cpu >= SMP_MAX_CPUS)
+    {
+        return (0);
+    }
+    size = workq_size(&g_workq[cpu]);
+    return (size > 0 ? (uint32_t)size : 0);
+}
+
+void workq_reset_stats(void)
+{
+    uint32_t    i;
+
+    for (i = 0; i < SMP_MAX_CPUS; i++)
+    {
+        g_workq[i].executed = 0;
+        g_workq[i].migrations = 0;
+        g_workq[i].steals = 0;
+        g_workq[i].stolen = 0;
+        g_workq[i].aborts = 0;
+    }
+}
+
+void workq_print_stats(void)
+{
+    const t_workq   *q;
+    uint32_t        i;
+
+    printk("Work queues (Chase-Lev, %u slots per CPU):\n", WORKQ_SIZE);
+    for (i = 0; i < smp_cpu_count(); i++)
+    {
+        q = &g_workq[i];
+        printk("  cpu %u  ran %u  migrated %u  steals %u (%u jobs)  aborts %u"
+               "  queued %u\n", i, q->executed, q->migrations, q->steals,
+               q->stolen, q->aborts, workq_pending(i));
+    }
+}
+
+static void workq_bench_job(void *arg)
+{
+    uint32_t    x;
+    uint32_t    i;
+
+    x = (uint32_t)arg | 1;
+    for (i = 0; i < WORKQ_BENCH_SPIN; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    __asm__ volatile ("" : : "r"(x));
+    atomic_inc(&g_bench_done);
+}
+
+static uint64_t workq_bench_pass(uint32_t jobs, uint32_t cpus)
+{
+    uint64_t    start;
+    uint32_t    i;
+
+    workq_reset_stats();
+    g_bench_done = 0;
+    g_workq_cpus = cpus;
+    start = ktime_ns();
+    for (i = 0; i < jobs; i++)
+    {
+        g_bench_work[i].fn = workq_bench_job;
+        g_bench_work[i].arg = (void *)(i + 1);
+        if (workq_push(&g_bench_work[i]) != 0)
+        {
+            workq_bench_job(g_bench_work[i].arg);
+        }
+    }
+    while (g_bench_done < jobs)
+    {
+        if (!workq_run_one())
+        {
+            cpu_relax();
+        }
+    }
+    start = ktime_ns() - start;
+    g_workq_cpus = SMP_MAX_CPUS;
+    return (start);
+}
+
+void workq_benchmark(uint32_t jobs)
+{
+    uint32_t    base_us;
+    uint32_t    elapsed_us;
+    uint32_t    online;
+    uint32_t    cpus;
+    uint32_t    speedup;
+
+    if (jobs > WORKQ_BENCH_MAX)
+    {
+        jobs = WORKQ_BENCH_MAX;
+    }
+    online = smp_online_count();
+    printk("Parallel benchmark: %u jobs x %u xorshift rounds\n",
+           jobs, WORKQ_BENCH_SPIN);
+    base_us = 0;
+    cpus = 1;
+    while (cpus <= online)
+    {
+        elapsed_us = (uint32_t)k_udivmod64(workq_bench_pass(jobs, cpus),
+                                           NSEC_PER_USEC, NULL) + 1;
+        if (base_us == 0)
+        {
+            base_us = elapsed_us;
+        }
+        speedup = (uint32_t)k_udivmod64((uint64_t)base_us * 100, elapsed_us,
+                                        NULL);
+        printk("  %u cpu(s)  %u ms  speedup %u.%u%u  efficiency %u%%\n",
+               cpus, elapsed_us / 1000, speedup / 100, (speedup / 10) % 10,
+               speedup % 10, speedup / cpus);
+        if (cpus == online)
+        {
+            break;
+        }
+        cpus = cpus * 2 > online ? online : cpus * 2;
+    }
+    workq_print_stats();
+}
@@ -0,0 +1,36 @@
+#include "math.h"
+
+/*
+** 64 / 32 division without libgcc: two chained divl, high word first.
+** Both steps are safe because each partial dividend's high half is
+** strictly below the divisor.
+*/
+uint64_t k_udivmod64(uint64_t dividend, uint32_t divisor, uint32_t *remainder)
+{
+    uint32_t    high;
+    uint32_t    low;
+    uint32_t    q_high;
+    uint32_t    q_low;
+    uint32_t    rem;
+
+    if (divisor == 0)
+    {
+        if (remainder != NULL)
+        {
+            *remainder = 0;
+        }
+        return (0);
+    }
+    high = (uint32_t)(dividend >> 32);
+    low = (uint32_t)dividend;
+    q_high = high / divisor;
+    rem = high % divisor;
+    __asm__ ("divl %4"
+             : "=a"(q_low), "=d"(rem)
+             : "a"(low), "d"(rem), "rm"(divisor));
+    if (remainder != NULL)
+    {
+        *remainder = rem;
+    }
+    return (((uint64_t)q_high << 32) | q_low);
+}
@@ -0,0 +1,8 @@
+#ifndef MATH_H
+#define MATH_H
+
+#include "../include/types.h"
+
+uint64_t    k_udivmod64(uint64_t dividend, uint32_t divisor, uint32_t *remainder);
+
+#endif
@@ -1,4 +1,5 @@
 #include "string.h"
+#include "math.h"
 
 void *k_memset(void *dest, int c, size_t n)
 {
@@ -279,3 +280,83 @@ void k_utoa(uint32_t value, char *buffer, int base)
     }
     buffer[j] = '\0';
 }
+
+void k_u64toa(uint64_t value, char *buffer, int base)
+{
+    static const char   digits[] = "0123456789ABCDEF";
+    char                temp[65];
+    uint32_t            digit;
+    int                 i;
+    int                 j;
+
+    if (buffer == NULL || base < 2 || base > 16)
+    {
+        return;
+    }
+    i = 0;
+    if (value == 0)
+    {
+        temp[i] = '0';
+        i++;
+    }
+    while (value > 0 && i < 64)
+    {
+        value = k_udivmod64(value, (uint32_t)base, &digit);
+        temp[i] = digits[digit];
+        i++;
+    }
+    j = 0;
+    while (i > 0)
+    {
+        i--;
+        buffer[j] = temp[i];
+        j++;
+    }
+    buffer[j] = '\0';
+}
+
+int k_atou(const char *str, uint32_t *value)
+{
+    uint32_t    base;
+    uint32_t    digit;
+    uint32_t    result;
+
+    if (str == NULL || value == NULL || *str == '\0')
+    {
+        return (-1);
+    }
+    base = 10;
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X') && str[2] != '\0')
+    {
+        base = 16;
+        str += 2;
+    }
+    result = 0;
+    while (*str != '\0')
+    {
+        if (*str >= '0' && *str <= '9')
+        {
+            digit = (uint32_t)(*str - '0');
+        }
+        else if (base == 16 && *str >= 'a' && *str <= 'f')
+        {
+            digit = (uint32_t)(*str - 'a' + 10);
+        }
+        else if (base == 16 && *str >= 'A' && *str <= 'F')
+        {
+            digit = (uint32_t)(*str - 'A' + 10);
+        }
+        else
+        {
+            return (-1);
+        }
+        if (digit >= base || result > (0xFFFFFFFFU - digit) / base)
+        {
+            return (-1);
+        }
+        result = result * base + digit;
+        str++;
+    }
+    *value = result;
+    return (0);
+}
@@ -16,5 +16,7 @@ char    *k_strncpy(char *dest, const char *src, size_t n);
 
 void    k_itoa(int32_t value, char *buffer, int base);
 void    k_utoa(uint32_t value, char *buffer, int base);
+void    k_u64toa(uint64_t value, char *buffer, int base);
+int     k_atou(const char *str, uint32_t *value);
 
 #endif